@@ -0,0 +1 @@
+../../src/sat/ipasir.h
\ No newline at end of file
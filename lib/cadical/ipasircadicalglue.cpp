@@ -0,0 +1,16 @@
+
+// Extra IPASIR functions which CaDiCaL's own IPASIR implementation does not provide.
+// CaDiCaL's ipasir_init() returns a handle of its C interface.
+
+extern "C" {
+    #include "ipasir.h"
+    #include "ccadical.h"
+
+    void ipasir_set_decision_var (void * s, unsigned int v, bool decision_var) { /*Not supported.*/ }
+    void ipasir_set_phase (void * s, unsigned int v, bool phase) { ccadical_phase((CCaDiCaL*) s, phase ? (int)v : -(int)v); }
+    void ipasir_set_seed (void * s, int seed) { ccadical_set_option((CCaDiCaL*) s, "seed", seed); }
+    void ipasir_set_frozen (void * s, unsigned int v, bool frozen) { 
+        if (frozen) ccadical_freeze((CCaDiCaL*) s, v);
+        else ccadical_melt((CCaDiCaL*) s, v);
+    }
+};
@@ -154,6 +154,8 @@ int ipasir_failed (void * s, int l) { return import (s)->failed (l); }
 void ipasir_set_terminate (void * s, void * state, int (*callback)(void * state)) { import(s)->setTermCallback(state, callback); }
 void ipasir_set_learn (void * s, void * state, int max_length, void (*learn)(void * state, int * clause)) { import(s)->setLearnCallback(state, max_length, learn); }
 void ipasir_set_decision_var (void * s, unsigned int v, bool decision_var) { import(s)->setDecisionVar(var(import(s)->import(v)), decision_var); }
-void ipasir_set_phase (void * s, unsigned int v, bool phase) { import(s)->setPolarity(var(import(s)->import(v)), phase); }
+// Glucose branches on the negative literal of a variable whose polarity is true
+void ipasir_set_phase (void * s, unsigned int v, bool phase) { import(s)->setPolarity(var(import(s)->import(v)), !phase); }
 void ipasir_set_seed (void * s, int seed) { import(s)->random_seed = seed; }
+void ipasir_set_frozen (void * s, unsigned int v, bool frozen) { /*Not implemented: no variable elimination.*/ }
 };
@@ -59,3 +59,4 @@ void ipasir_set_learn (void * solver, void * state, int max_length, void (*learn
 void ipasir_set_decision_var (void * s, unsigned int v, bool decision_var) { /*Not implemented.*/ }
 void ipasir_set_phase (void * s, unsigned int v, bool phase) { /*Not implemented.*/ }
 void ipasir_set_seed (void * s, int seed) { /*Not implemented.*/ }
+void ipasir_set_frozen (void * s, unsigned int v, bool frozen) { /*Not implemented.*/ }
@@ -0,0 +1,332 @@
+#!/usr/bin/env python3
+
+"""
+End-to-end benchmark driver for lilotane.
+
+Runs a set of instances under a matrix of parameter configurations, collects the
+JSON lines metrics (-mf) of each run into a results file and compares results
+against a stored baseline.
+
+  # Run the default instance set with two configurations, three repetitions each
+  scripts/benchmark.py run -c default= -c noedo="-edo=0" -r 3 -o results.jsonl
+
+  # Compare against a baseline; exits with code 1 if a significant regression is found
+  scripts/benchmark.py compare baseline.jsonl results.jsonl
+
+  # Scaling curves over generated instance families (see generate_instances.py)
+  scripts/benchmark.py scaling results.jsonl
+
+Instance sets are text files with one "<domain> <problem> [<family> <size>]" entry
+per line (paths relative to the repository root; '#' starts a comment), or a list of
+glob patterns over instances/ given via -i (e.g. -i 'blocksworld/p0[1-5].hddl').
+"""
+
+import argparse
+import glob
+import json
+import os
+import resource
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_SET = os.path.join(REPO, "scripts", "benchmark_instances.txt")
+
+# Metrics compared against the baseline: name -> (relative threshold, absolute threshold).
+# A difference only counts as significant if it exceeds both thresholds
+# as well as the noise (standard deviation over repetitions) of either run.
+METRICS = {
+    "time_to_first_plan": (0.10, 0.5),
+    "instantiation_time": (0.10, 0.5),
+    "encoding_time": (0.10, 0.5),
+    "total_time": (0.10, 0.5),
+    "peak_rss_kb": (0.10, 20000),
+    "clauses": (0.02, 1000),
+    "variables": (0.02, 1000),
+    "plan_length": (0.0, 0),
+    "layers": (0.0, 0),
+}
+
+
+def read_instance_set(args):
+    instances = []
+    if args.instances:
+        for pattern in args.instances:
+            for problem in sorted(glob.glob(os.path.join(REPO, "instances", pattern))):
+                if os.path.basename(problem) == "domain.hddl":
+                    continue
+                domain = os.path.join(os.path.dirname(problem), "domain.hddl")
+                instances.append((os.path.relpath(domain, REPO), os.path.relpath(problem, REPO), None, None))
+    else:
+        with open(args.set) as f:
+            for line in f:
+                line = line.split("#")[0].split()
+                if len(line) >= 4:
+                    instances.append((line[0], line[1], line[2], int(line[3])))
+                elif len(line) >= 2:
+                    instances.append((line[0], line[1], None, None))
+    if not instances:
+        sys.exit("No instances selected.")
+    return instances
+
+
+def parse_configs(args):
+    configs = []
+    for c in args.config or ["default="]:
+        name, _, params = c.partition("=")
+        configs.append((name, params.split()))
+    return configs
+
+
+def run_instance(binary, domain, problem, params, timeout):
+    """Runs lilotane once and assembles a result record from its metrics stream."""
+
+    with tempfile.NamedTemporaryFile(suffix=".jsonl", delete=False) as tmp:
+        metrics_file = tmp.name
+    with tempfile.NamedTemporaryFile(suffix=".csv", delete=False) as tmp:
+        profile_file = tmp.name
+    cmd = [binary, domain, problem, "-mf=" + metrics_file, "-spf=" + profile_file, "-v=0"] + params
+
+    start = time.time()
+    proc = subprocess.Popen(cmd, cwd=REPO, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    status = None
+    while True:
+        pid, exitcode, rusage = os.wait4(proc.pid, os.WNOHANG)
+        if pid != 0:
+            break
+        if time.time() - start > timeout:
+            proc.kill()
+            pid, exitcode, rusage = os.wait4(proc.pid, 0)
+            status = "timeout"
+            break
+        time.sleep(0.01)
+    wallclock = time.time() - start
+    proc.returncode = returncode = os.waitstatus_to_exitcode(exitcode)
+
+    records = []
+    with open(metrics_file) as f:
+        for line in f:
+            try:
+                records.append(json.loads(line))
+            except json.JSONDecodeError:
+                pass  # truncated last line of a killed run
+    os.unlink(metrics_file)
+
+    # Stage profile: split the time spent per position into instantiation and encoding
+    instantiation_time = 0
+    encoding_time = 0
+    with open(profile_file) as f:
+        for line in f:
+            fields = line.split(",")
+            if len(fields) < 4 or fields[2] in ("stage", "position"):
+                continue
+            try:
+                seconds = float(fields[3])
+            except ValueError:
+                continue  # truncated last line of a killed run
+            if fields[2] == "instantiation":
+                instantiation_time += seconds
+            else:
+                encoding_time += seconds
+    os.unlink(profile_file)
+
+    layers = [r for r in records if r["event"] == "layer"]
+    plans = [r for r in records if r["event"] == "plan"]
+    sat_calls = [r for r in records if r["event"] == "sat"]
+    first_sat = next((r for r in sat_calls if r.get("result") == "sat"), None)
+
+    if status is None:
+        status = "solved" if returncode == 0 and plans else \
+            ("unsolved" if returncode in (0, 1) else "crashed")
+
+    layer_times = []
+    prev = 0
+    for r in layers:
+        layer_times.append(round(r["time"] - prev, 4))
+        prev = r["time"]
+
+    last = next((r for r in reversed(records) if "clauses" in r), {})
+    return {
+        "status": status,
+        "exit_code": returncode,
+        "total_time": round(wallclock, 4),
+        "time_to_first_plan": first_sat["time"] if first_sat else None,
+        "instantiation_time": round(instantiation_time, 4),
+        "encoding_time": round(encoding_time, 4),
+        "layer_times": layer_times,
+        "sat_times": [r.get("sat_time") for r in sat_calls],
+        "layers": len(layers),
+        # ru_maxrss is in kB on Linux
+        "peak_rss_kb": rusage.ru_maxrss if sys.platform != "darwin" else rusage.ru_maxrss // 1024,
+        "clauses": last.get("clauses"),
+        "variables": last.get("variables"),
+        "plan_length": plans[-1]["plan_length"] if plans else None,
+    }
+
+
+def cmd_run(args):
+    instances = read_instance_set(args)
+    configs = parse_configs(args)
+    binary = os.path.abspath(args.binary)
+
+    with open(args.output, "a" if args.append else "w") as out:
+        total = len(instances) * len(configs) * args.repetitions
+        n = 0
+        for domain, problem, family, size in instances:
+            for name, params in configs:
+                for rep in range(args.repetitions):
+                    n += 1
+                    print("[%i/%i] %s %s (%s, #%i) ... " % (n, total, domain, problem, name, rep),
+                          end="", flush=True)
+                    result = run_instance(binary, domain, problem, params, args.timeout)
+                    record = {"domain": domain, "problem": problem, "config": name,
+                              "params": " ".join(params), "repetition": rep}
+                    if family is not None:
+                        record.update({"family": family, "size": size})
+                    record.update(result)
+                    out.write(json.dumps(record) + "\n")
+                    out.flush()
+                    print("%s in %.2fs" % (result["status"], result["total_time"]))
+
+
+def load_results(filename):
+    """Groups the records of a results file by (problem, config)."""
+    groups = {}
+    with open(filename) as f:
+        for line in f:
+            if line.strip():
+                r = json.loads(line)
+                groups.setdefault((r["problem"], r["config"]), []).append(r)
+    return groups
+
+
+def summarize(records, metric):
+    values = [r[metric] for r in records if r["status"] == "solved" and r.get(metric) is not None]
+    if not values:
+        return None, 0
+    return statistics.median(values), statistics.stdev(values) if len(values) > 1 else 0
+
+
+def cmd_compare(args):
+    baseline = load_results(args.baseline)
+    current = load_results(args.results)
+
+    regressions = 0
+    improvements = 0
+    for key in sorted(set(baseline) | set(current)):
+        problem, config = key
+        if key not in baseline or key not in current:
+            print("%-50s %-10s only in %s" % (problem, config, "baseline" if key in baseline else "results"))
+            continue
+        solved_base = sum(r["status"] == "solved" for r in baseline[key])
+        solved_cur = sum(r["status"] == "solved" for r in current[key])
+        lines = []
+        if solved_cur < solved_base:
+            regressions += 1
+            lines.append("solved %i/%i -> %i/%i  REGRESSION"
+                         % (solved_base, len(baseline[key]), solved_cur, len(current[key])))
+        elif solved_cur > solved_base:
+            improvements += 1
+            lines.append("solved %i/%i -> %i/%i  improvement"
+                         % (solved_base, len(baseline[key]), solved_cur, len(current[key])))
+
+        for metric, (rel, abs_) in METRICS.items():
+            base, noise_base = summarize(baseline[key], metric)
+            cur, noise_cur = summarize(current[key], metric)
+            if base is None or cur is None:
+                continue
+            diff = cur - base
+            threshold = max(rel * abs(base), abs_, args.noise_factor * max(noise_base, noise_cur))
+            if abs(diff) <= threshold:
+                if args.verbose:
+                    lines.append("%-20s %12.6g -> %12.6g" % (metric, base, cur))
+                continue
+            # All compared metrics are "lower is better"
+            verdict = "REGRESSION" if diff > 0 else "improvement"
+            if diff > 0:
+                regressions += 1
+            else:
+                improvements += 1
+            lines.append("%-20s %12.6g -> %12.6g  (%+.1f%%)  %s"
+                         % (metric, base, cur, 100 * diff / base if base else float("inf"), verdict))
+        if lines:
+            print("%s (%s)" % (problem, config))
+            for line in lines:
+                print("  " + line)
+
+    print("%i significant regressions, %i significant improvements." % (regressions, improvements))
+    return 1 if regressions > 0 else 0
+
+
+def cmd_scaling(args):
+    """Prints one CSV table per instance family and configuration, ordered by size."""
+
+    groups = {}
+    with open(args.results) as f:
+        for line in f:
+            if line.strip():
+                r = json.loads(line)
+                if "family" in r:
+                    groups.setdefault((r["family"], r["config"]), {}).setdefault(r["size"], []).append(r)
+    if not groups:
+        sys.exit("No results of generated instance families found.")
+
+    columns = args.metrics.split(",")
+    for (family, config), by_size in sorted(groups.items()):
+        print("# %s (%s)" % (family, config))
+        print(",".join(["size", "solved"] + columns))
+        for size, records in sorted(by_size.items()):
+            solved = sum(r["status"] == "solved" for r in records)
+            row = [str(size), "%i/%i" % (solved, len(records))]
+            for metric in columns:
+                # Report medians over all runs (including unsolved ones) to see where scaling breaks down
+                values = [r[metric] for r in records if r.get(metric) is not None]
+                row.append("%.6g" % statistics.median(values) if values else "")
+            print(",".join(row))
+        print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End-to-end benchmarks for lilotane")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    run = sub.add_parser("run", help="run instances and write a results file")
+    run.add_argument("-s", "--set", default=DEFAULT_SET, help="instance set file (default: %(default)s)")
+    run.add_argument("-i", "--instances", action="append",
+                     help="glob pattern of problem files below instances/ (overrides --set; repeatable)")
+    run.add_argument("-c", "--config", action="append",
+                     help='configuration as name="<lilotane params>" (repeatable; default: default=)')
+    run.add_argument("-r", "--repetitions", type=int, default=1, help="runs per instance and configuration")
+    run.add_argument("-t", "--timeout", type=float, default=60, help="timeout per run in seconds")
+    run.add_argument("-b", "--binary", default=os.path.join(REPO, "lilotane"), help="lilotane executable")
+    run.add_argument("-o", "--output", default="results.jsonl", help="results file")
+    run.add_argument("-a", "--append", action="store_true", help="append to the results file")
+
+    compare = sub.add_parser("compare", help="compare a results file against a baseline")
+    compare.add_argument("baseline")
+    compare.add_argument("results")
+    compare.add_argument("-n", "--noise-factor", type=float, default=2.0,
+                         help="differences within this many standard deviations are considered noise")
+    compare.add_argument("-v", "--verbose", action="store_true", help="also list insignificant differences")
+
+    scaling = sub.add_parser("scaling", help="tabulate metrics over the sizes of generated instance families")
+    scaling.add_argument("results")
+    scaling.add_argument("-m", "--metrics",
+                         default="instantiation_time,encoding_time,total_time,clauses,variables,peak_rss_kb,layers",
+                         help="comma-separated metrics to tabulate")
+
+    args = parser.parse_args()
+    if args.command == "run":
+        resource.setrlimit(resource.RLIMIT_CORE, (0, 0))
+        cmd_run(args)
+    elif args.command == "scaling":
+        cmd_scaling(args)
+    else:
+        sys.exit(cmd_compare(args))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+
+"""
+Generator of parameterized HDDL instance families for scaling studies.
+
+Each generated instance is written to <outdir>/<family>-<size>/{domain,problem}.hddl
+and appended to the instance set <outdir>/instances.txt which can be run
+directly by the benchmark driver:
+
+  scripts/generate_instances.py transport --sizes 2,4,8,16 -o gen/
+  scripts/generate_instances.py recursive --sizes 2,3,4,5 --fanout 2 --methods 3 -o gen/
+  scripts/benchmark.py run -s gen/instances.txt -r 3 -o scaling.jsonl
+  scripts/benchmark.py scaling scaling.jsonl
+
+Families and the meaning of their size parameter:
+  transport   number of packages (trucks, locations, capacity via options)
+  blocksworld number of blocks
+  recursive   recursion depth of a synthetic method hierarchy
+              (fan-out of recursive calls and number of alternative methods via options)
+
+All randomness is derived from --seed, so the same arguments always produce the same files.
+"""
+
+import argparse
+import os
+import random
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def connected_road_network(rng, num_locations, extra_roads):
+    """Random connected, undirected graph: a random spanning tree plus some extra edges."""
+    roads = set()
+    order = list(range(num_locations))
+    rng.shuffle(order)
+    for i in range(1, num_locations):
+        a, b = order[i], order[rng.randrange(i)]
+        roads.add((min(a, b), max(a, b)))
+    for _ in range(extra_roads):
+        a, b = rng.sample(range(num_locations), 2)
+        roads.add((min(a, b), max(a, b)))
+    return sorted(roads)
+
+
+def transport_problem(rng, name, num_packages, args):
+    num_trucks = args.trucks or max(1, num_packages // 4)
+    num_locations = args.locations or max(3, num_packages)
+    capacity = args.capacity
+
+    objects = ["package_%i - package" % p for p in range(num_packages)]
+    objects += ["capacity_%i - capacity_number" % c for c in range(capacity + 1)]
+    objects += ["city_loc_%i - location" % l for l in range(num_locations)]
+    objects += ["truck_%i - vehicle" % t for t in range(num_trucks)]
+
+    tasks = []
+    init = ["(capacity_predecessor capacity_%i capacity_%i)" % (c, c + 1) for c in range(capacity)]
+    for a, b in connected_road_network(rng, num_locations, num_locations // 2):
+        init += ["(road city_loc_%i city_loc_%i)" % (a, b), "(road city_loc_%i city_loc_%i)" % (b, a)]
+    for p in range(num_packages):
+        start, goal = rng.sample(range(num_locations), 2)
+        init.append("(at package_%i city_loc_%i)" % (p, start))
+        tasks.append("(deliver package_%i city_loc_%i)" % (p, goal))
+    for t in range(num_trucks):
+        init.append("(at truck_%i city_loc_%i)" % (t, rng.randrange(num_locations)))
+        init.append("(capacity truck_%i capacity_%i)" % (t, capacity))
+
+    return "\n".join([
+        "(define",
+        "\t(problem %s)" % name,
+        "\t(:domain  domain_htn)",
+        "\t(:objects",
+        "\n".join("\t\t" + o for o in objects),
+        "\t)",
+        "\t(:htn",
+        "\t\t:parameters ()",
+        "\t\t:subtasks (and",
+        "\n".join("\t\t (task%i %s)" % (i, t) for i, t in enumerate(tasks)),
+        "\t\t)",
+        "\t\t:ordering (and",
+        "\n".join("\t\t\t(task%i < task%i)" % (i, i + 1) for i in range(len(tasks) - 1)),
+        "\t\t)",
+        "\t)",
+        "\t(:init",
+        "\n".join("\t\t" + f for f in init),
+        "\t)",
+        ")",
+        ""])
+
+
+def random_towers(rng, blocks):
+    """Randomly distributes the blocks over towers, each listed from bottom to top."""
+    blocks = blocks[:]
+    rng.shuffle(blocks)
+    towers = []
+    while blocks:
+        height = rng.randint(1, len(blocks))
+        towers.append(blocks[:height])
+        blocks = blocks[height:]
+    return towers
+
+
+def blocksworld_problem(rng, name, num_blocks, args):
+    blocks = ["b%i" % (i + 1) for i in range(num_blocks)]
+
+    init = ["(handempty)"]
+    for tower in random_towers(rng, blocks):
+        init.append("(ontable %s)" % tower[0])
+        init += ["(on %s %s)" % (tower[i + 1], tower[i]) for i in range(len(tower) - 1)]
+        init.append("(clear %s)" % tower[-1])
+
+    # Build each goal tower bottom-up
+    tasks = []
+    goal = []
+    for tower in random_towers(rng, blocks):
+        for i in range(len(tower) - 1):
+            tasks.append("(do_put_on %s %s)" % (tower[i + 1], tower[i]))
+            goal.append("(on %s %s)" % (tower[i + 1], tower[i]))
+    if not tasks:
+        # Everything on the table: keep the task network non-empty
+        tasks.append("(do_on_table %s)" % blocks[0])
+        goal.append("(ontable %s)" % blocks[0])
+
+    return "\n".join([
+        "(define (problem %s)" % name,
+        "(:domain blocksworld)",
+        "(:requirements :typing :hierachie)",
+        "(:objects %s - block)" % " ".join(blocks),
+        "(:htn :parameters () :ordered-subtasks (and",
+        "\n".join("(task%i %s)" % (i + 1, t) for i, t in enumerate(tasks)),
+        "))",
+        "(:init",
+        "\n".join(init),
+        ")",
+        "\t(:goal (and",
+        "\n".join(goal),
+        "\t))",
+        ")",
+        ""])
+
+
+def recursive_domain(args):
+    """
+    Synthetic hierarchy: (rec ?c) either terminates at the last counter or performs
+    (work ?o ?c) followed by <fanout> recursive calls (rec ?d) at the next counter ?d.
+    Each of the <methods> alternative recursive methods is only applicable to the
+    objects of its variant, so the planner needs to choose among them at each node.
+    """
+    lines = [
+        "(define (domain synthetic_recursive)",
+        "",
+        "(:requirements :typing :hierachie)",
+        "",
+        "(:types counter obj)",
+        "",
+        "(:predicates (next ?c - counter ?d - counter) (last ?c - counter) (done ?o - obj ?c - counter)",
+        "  %s)" % " ".join("(variant_%i ?o - obj)" % m for m in range(args.methods)),
+        "",
+        "(:task rec :parameters (?c - counter))",
+        "(:task work :parameters (?o - obj ?c - counter))",
+        "",
+        "(:method m_rec_base",
+        "  :parameters (?c - counter)",
+        "  :task (rec ?c)",
+        "  :precondition (and (last ?c))",
+        "  :ordered-subtasks (and (t1 (nop))) )",
+        ""]
+    calls = " ".join("(t%i (rec ?d))" % (i + 2) for i in range(args.fanout))
+    for m in range(args.methods):
+        lines += [
+            "(:method m_rec_step_%i" % m,
+            "  :parameters (?c - counter ?d - counter ?o - obj)",
+            "  :task (rec ?c)",
+            "  :precondition (and (next ?c ?d) (variant_%i ?o))" % m,
+            "  :ordered-subtasks (and (t1 (work ?o ?c)) %s) )" % calls,
+            ""]
+    lines += [
+        "(:method m_work",
+        "  :parameters (?o - obj ?c - counter)",
+        "  :task (work ?o ?c)",
+        "  :ordered-subtasks (and (t1 (do_work ?o ?c))) )",
+        "",
+        "(:action do_work",
+        "  :parameters (?o - obj ?c - counter)",
+        "  :precondition ()",
+        "  :effect (and (done ?o ?c)))",
+        "",
+        "(:action nop",
+        "  :parameters ()",
+        "  :precondition ()",
+        "  :effect ())",
+        ")",
+        ""]
+    return "\n".join(lines)
+
+
+def recursive_problem(rng, name, depth, args):
+    counters = ["c%i" % i for i in range(depth + 1)]
+    objects = ["o%i" % i for i in range(args.objects)]
+    init = ["(next %s %s)" % (counters[i], counters[i + 1]) for i in range(depth)]
+    init.append("(last %s)" % counters[-1])
+    for o in objects:
+        # Each object supports two (random) of the alternative methods
+        for m in set(rng.sample(range(args.methods), min(2, args.methods))):
+            init.append("(variant_%i %s)" % (m, o))
+
+    return "\n".join([
+        "(define (problem %s)" % name,
+        "(:domain synthetic_recursive)",
+        "(:requirements :typing :hierachie)",
+        "(:objects %s - counter %s - obj)" % (" ".join(counters), " ".join(objects)),
+        "(:htn :parameters () :ordered-subtasks (and (task1 (rec c0))))",
+        "(:init",
+        "\n".join(init),
+        ")",
+        ")",
+        ""])
+
+
+FAMILIES = {
+    "transport": (lambda args: open(os.path.join(REPO, "instances", "transport", "domain.hddl")).read(),
+                  transport_problem),
+    "blocksworld": (lambda args: open(os.path.join(REPO, "instances", "blocksworld", "domain.hddl")).read(),
+                    blocksworld_problem),
+    "recursive": (recursive_domain, recursive_problem),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate parameterized HDDL instance families")
+    parser.add_argument("family", choices=sorted(FAMILIES))
+    parser.add_argument("--sizes", default="2,4,8", help="comma-separated sizes to generate")
+    parser.add_argument("-o", "--outdir", default="generated", help="output directory")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--tag", default="",
+                        help="suffix for the family name, to tell apart several option settings")
+    # transport
+    parser.add_argument("--trucks", type=int, default=0, help="transport: trucks (0: one per four packages)")
+    parser.add_argument("--locations", type=int, default=0, help="transport: locations (0: one per package, at least 3)")
+    parser.add_argument("--capacity", type=int, default=2, help="transport: truck capacity")
+    # recursive
+    parser.add_argument("--fanout", type=int, default=2, help="recursive: recursive calls per method")
+    parser.add_argument("--methods", type=int, default=2, help="recursive: alternative recursive methods")
+    parser.add_argument("--objects", type=int, default=4, help="recursive: number of objects")
+    args = parser.parse_args()
+
+    make_domain, make_problem = FAMILIES[args.family]
+    family = args.family + args.tag
+    os.makedirs(args.outdir, exist_ok=True)
+    instance_set = os.path.join(args.outdir, "instances.txt")
+
+    with open(instance_set, "a") as out:
+        for size in [int(s) for s in args.sizes.split(",")]:
+            # Derive a distinct but reproducible random state for each instance
+            rng = random.Random("%s/%i/%i" % (family, size, args.seed))
+            name = "%s-%i" % (family, size)
+            directory = os.path.join(args.outdir, name)
+            os.makedirs(directory, exist_ok=True)
+            domain = os.path.join(directory, "domain.hddl")
+            problem = os.path.join(directory, "problem.hddl")
+            with open(domain, "w") as f:
+                f.write(make_domain(args))
+            with open(problem, "w") as f:
+                f.write(make_problem(rng, name, size, args))
+            out.write("%s %s %s %i\n" % (os.path.abspath(domain), os.path.abspath(problem), family, size))
+            print("Wrote %s" % directory)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+
+#include "algo/depth_oracle.h"
+#include "util/log.h"
+
+bool DepthOracle::canContainPlan(Layer& layer) {
+
+    if (!_initialized) init();
+
+    _pos_facts = _init_state;
+    _neg_facts.clear();
+    int numActionPositions = 0;
+
+    for (size_t pos = 0; pos < layer.size(); pos++) {
+        Position& position = layer[pos];
+        USigSet newPosFacts, newNegFacts;
+        bool primitive = false;
+        bool hasAction = false;
+
+        for (const USignature& aSig : position.getActions()) {
+            const Action& a = _htn.getOpTable().getAction(aSig);
+            if (!isApplicable(a.getPreconditions()) || !isApplicable(a.getExtraPreconditions())) continue;
+            primitive = true;
+            if (!isBlank(aSig._name_id) && aSig._name_id != _goal_action_name) hasAction = true;
+            addEffects(a.getEffects(), newPosFacts, newNegFacts);
+        }
+        for (const USignature& rSig : position.getReductions()) {
+            if (primitive) break;
+            const Reduction& r = _htn.getOpTable().getReduction(rSig);
+            if (r.getSubtasks().empty() && isApplicable(r.getPreconditions())) primitive = true;
+        }
+
+        if (!primitive) {
+            Log::i("Depth oracle: no relaxed applicable primitive operation at (%i,%i)\n", layer.index(), pos);
+            return false;
+        }
+        if (hasAction) numActionPositions++;
+        
+        _pos_facts.insert(newPosFacts.begin(), newPosFacts.end());
+        _neg_facts.insert(newNegFacts.begin(), newNegFacts.end());
+    }
+
+    if (numActionPositions < _min_num_actions) {
+        Log::i("Depth oracle: only %i positions of layer %i can hold an action, but at least %i actions are required\n", 
+                numActionPositions, layer.index(), _min_num_actions);
+        return false;
+    }
+    return true;
+}
+
+void DepthOracle::init() {
+    _init_state = _htn.getInitState();
+    _goal_action_name = _htn.nameId("<goal_action>");
+
+    // Minimum number of actions in any full expansion of the initial reduction
+    _minres.computeMinNumPrimitiveChildren();
+    int initReductionName = _htn.getInitReduction().getSignature()._name_id;
+    _min_num_actions = _htn.getReductionTemplates().count(initReductionName) ? 
+            _minres.getMinNumPrimitiveChildren(initReductionName) : 0;
+    if (_min_num_actions >= MinRES::INFINITE_SIZE) {
+        Log::w("Depth oracle: the initial reduction cannot be expanded into a finite plan\n");
+    } else {
+        Log::i("Depth oracle: every plan consists of at least %i actions\n", _min_num_actions);
+    }
+    _initialized = true;
+}
+
+bool DepthOracle::isApplicable(const SigSet& preconditions) {
+    for (const Signature& pre : preconditions) {
+        if (!mayHold(pre._usig, pre._negated)) return false;
+    }
+    return true;
+}
+
+bool DepthOracle::mayHold(const USignature& fact, bool negated) {
+    // Lifted facts are not checked
+    if (!_htn.isFullyGround(fact)) return true;
+    // A q-fact may hold if some of its decodings may hold
+    if (_htn.hasQConstants(fact)) {
+        for (const USignature& decFact : _htn.decodeObjects(fact, _htn.getEligibleArgs(fact))) {
+            if (mayHold(decFact, negated)) return true;
+        }
+        return false;
+    }
+    if (negated) return !_init_state.count(fact) || _neg_facts.count(fact);
+    return _pos_facts.count(fact);
+}
+
+void DepthOracle::addEffects(const SigSet& effects, USigSet& newPosFacts, USigSet& newNegFacts) {
+    for (const Signature& eff : effects) {
+        USigSet& facts = eff._negated ? newNegFacts : newPosFacts;
+        if (!_htn.isFullyGround(eff._usig)) continue;
+        if (_htn.hasQConstants(eff._usig)) {
+            // Each decoding of a q-fact may be affected
+            for (const USignature& decFact : _htn.decodeObjects(eff._usig, _htn.getEligibleArgs(eff._usig))) {
+                facts.insert(decFact);
+            }
+        } else facts.insert(eff._usig);
+    }
+}
+
+bool DepthOracle::isBlank(int actionName) {
+    int blankName = _htn.getBlankActionSig()._name_id;
+    return actionName == blankName 
+        || (_htn.isActionRepetition(actionName) && _htn.getActionNameFromRepetition(actionName) == blankName);
+}
@@ -0,0 +1,46 @@
+
+#ifndef DOMPASCH_LILOTANE_DEPTH_ORACLE_H
+#define DOMPASCH_LILOTANE_DEPTH_ORACLE_H
+
+#include "data/htn_instance.h"
+#include "data/layer.h"
+#include "algo/minres.h"
+
+/*
+Cheap necessary conditions for a layer to contain a plan, i.e., for all of its
+positions to be primitive at the same time:
+  - every position has a primitive operation which is applicable in a delete-free
+    relaxation of the sequence of positions (including the goal action at the end);
+  - enough positions have a non-blank action to hold the minimum number of actions
+    which any full expansion of the initial reduction consists of (MinRES).
+If a layer fails one of these conditions, a SAT call at this layer is hopeless.
+*/
+class DepthOracle {
+
+private:
+    HtnInstance& _htn;
+    MinRES& _minres;
+
+    bool _initialized = false;
+    int _min_num_actions;
+    USigSet _init_state;
+    int _goal_action_name;
+
+    // Delete-free reachability: facts which may be true resp. false at the current position
+    USigSet _pos_facts;
+    USigSet _neg_facts;
+
+public:
+    DepthOracle(HtnInstance& htn, MinRES& minres) : _htn(htn), _minres(minres) {}
+
+    bool canContainPlan(Layer& layer);
+
+private:
+    void init();
+    bool isApplicable(const SigSet& preconditions);
+    bool mayHold(const USignature& fact, bool negated);
+    void addEffects(const SigSet& effects, USigSet& newPosFacts, USigSet& newNegFacts);
+    bool isBlank(int actionName);
+};
+
+#endif
@@ -1,5 +1,9 @@
 
+
+#include <algorithm>
+
 #include "algo/domination_resolver.h"
+#include "util/timer.h"
 
 DominationResolver::DominationResult DominationResolver::getDominationStatus(const USignature& op, const USignature& other, Position& p) {
     DominationResult res;
@@ -37,13 +41,18 @@ DominationResolver::DominationResult DominationResolver::getDominationStatus(con
         if (!isOtherQ) dummyDomain.insert(otherArg);
         assert(dummyDomain.size() <= 1);
 
+        int domId = isQ ? getDomainId(arg) : -1;
+        int otherDomId = isOtherQ ? getDomainId(otherArg) : -1;
+
         if (domain.size() > otherDomain.size()) {
             // This op may dominate the other op
 
             // Contradicts previous argument indices -> ops are different
             if (status == DOMINATED) return res;
             // Check if this domain actually contains the other domain
-            for (int c : otherDomain) if (!domain.count(c)) return res;
+            if (isQ && isOtherQ) {
+                if (!isSubdomain(otherDomId, domId)) return res;
+            } else for (int c : otherDomain) if (!domain.count(c)) return res;
             // Yes: Dominating w.r.t. this position
             status = DOMINATING;
             res.qconstSubstitutions[otherArg] = arg;
@@ -52,14 +61,16 @@ DominationResolver::DominationResult DominationResolver::getDominationStatus(con
             // This op may be dominated by the other op
 
             // Contradicts previous argument indices -> ops are different
-            if (status == DOMINATED) return res;
+            if (status == DOMINATING) return res;
             // Check if the other domain actually contains this domain
-            for (int c : domain) if (!otherDomain.count(c)) return res;
+            if (isQ && isOtherQ) {
+                if (!isSubdomain(domId, otherDomId)) return res;
+            } else for (int c : domain) if (!otherDomain.count(c)) return res;
             // Yes: Dominated w.r.t. this position
             status = DOMINATED;
             res.qconstSubstitutions[arg] = otherArg;
 
-        } else if (domain != otherDomain) {
+        } else if (isQ && isOtherQ ? domId != otherDomId : domain != otherDomain) {
             // Different domains
             return res;
 
@@ -105,6 +116,11 @@ void DominationResolver::eliminateDominatedOperations(Position& newPos) {
     // Map of an op name id to (map of a dominating op to a set of dominated ops)
     NodeHashMap<int, NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>> dominatingActionsByName;
     NodeHashMap<int, NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>> dominatingReductionsByName;
+    
+    // Map of an op name id to the buckets of its currently dominating ops
+    NodeHashMap<int, BucketsByMask> bucketsByName;
+    FlatHashMap<IntPair, int, IntPairHasher> originIds;
+    std::vector<int> mask, key;
 
     // For each operation
     const USigSet* ops[2] = {&newPos.getActions(), &newPos.getReductions()};
@@ -113,32 +129,58 @@ void DominationResolver::eliminateDominatedOperations(Position& newPos) {
     };
     for (size_t i = 0; i < 2; i++) {
 
+        bucketsByName.clear();
+
         for (const auto& op : *ops[i]) {
             auto& dominatingOps = (*dMaps[i])[op._name_id];
+            auto& buckets = bucketsByName[op._name_id];
+            getBucketKey(op, mask, key, originIds);
 
-            // Compare operation with each currently dominating op of the same name
             USigSubstitutionMap dominated;
-            
-            if (dominatingOps.empty()) {
-                dominatingOps[op];
-                continue;
-            }
+            bool isDominated = false;
+            size_t numChecks = 0;
+            double time = Timer::now();
 
-            for (auto& [other, dominatedByOther] : dominatingOps) {
-                auto result = getDominationStatus(op, other, newPos);
-                if (result.status == DOMINATED) {
-                    // This op is being dominated; mark for deletion
-                    //Log::d("DOM %s << %s\n", TOSTR(op), TOSTR(other));
-                    dominatedByOther[op] = std::move(result.qconstSubstitutions);
-                    dominated.clear();
-                    break;
+            auto compareWithBucket = [&](const std::vector<USignature>& bucket) {
+                for (const auto& other : bucket) {
+                    numChecks++;
+                    auto result = getDominationStatus(op, other, newPos);
+                    if (result.status == DOMINATED) {
+                        // This op is being dominated; mark for deletion
+                        //Log::d("DOM %s << %s\n", TOSTR(op), TOSTR(other));
+                        dominatingOps.at(other)[op] = std::move(result.qconstSubstitutions);
+                        dominated.clear();
+                        isDominated = true;
+                        return;
+                    }
+                    if (result.status == DOMINATING) {
+                        // This op dominates the other op
+                        //Log::d("DOM %s >> %s\n", TOSTR(op), TOSTR(other));
+                        dominated[other] = std::move(result.qconstSubstitutions);
+                    }
                 }
-                if (result.status == DOMINATING) {
-                    // This op dominates the other op
-                    //Log::d("DOM %s >> %s\n", TOSTR(op), TOSTR(other));
-                    dominated[other] = std::move(result.qconstSubstitutions);
+            };
+
+            // Compare operation with each currently dominating op of the same name in a compatible bucket
+            for (auto& [otherMask, bucketsOfMask] : buckets) {
+                if (otherMask == mask) {
+                    // Same q-constant positions: only the bucket with the exact same key is compatible
+                    auto it = bucketsOfMask.find(key);
+                    if (it != bucketsOfMask.end()) compareWithBucket(it->second);
+                } else {
+                    for (auto& [otherKey, bucket] : bucketsOfMask) {
+                        if (areBucketsCompatible(key, otherKey)) compareWithBucket(bucket);
+                        if (isDominated) break;
+                    }
                 }
+                if (isDominated) break;
             }
+
+            _domination_check_time += Timer::now() - time;
+            _num_domination_checks += numChecks;
+            if (!isDominated) _num_skipped_domination_checks += dominatingOps.size() - numChecks;
+            if (isDominated) continue;
+
             // Delete all ops transitively dominated by this op
             assert(!dominatingOps.count(op));
             for (const auto& [other, s] : dominated) {
@@ -160,15 +202,26 @@ void DominationResolver::eliminateDominatedOperations(Position& newPos) {
                             subVec.push_back(cat); 
                         }
                         dominatingOps.erase(dominatedOp);
+
+                        // Remove the op from its bucket
+                        std::vector<int> domMask, domKey;
+                        getBucketKey(dominatedOp, domMask, domKey, originIds);
+                        auto& bucket = buckets[domMask][domKey];
+                        bucket.erase(std::find(bucket.begin(), bucket.end(), dominatedOp));
+                        if (bucket.empty()) buckets[domMask].erase(domKey);
                     }
                 }
             }
+
+            // This op is not dominated (yet)
+            dominatingOps[op];
+            buckets[mask][key].push_back(op);
         }
 
         // Remove all dominated ops
         for (auto& [nameId, dMap] : *dMaps[i]) for (auto& [op, dominated] : dMap) {
             for (auto& [other, s] : dominated) {
-                Log::v("%s dominates %s (%s)\n", TOSTR(op), TOSTR(other), TOSTR(s));
+                LOG_V("%s dominates %s (%s)\n", TOSTR(op), TOSTR(other), TOSTR(s));
                 //assert(other.substitute(s) == op);
                 newPos.replaceOperation(other, op, std::move(s));
                 _num_dominated_ops++;
@@ -176,3 +229,69 @@ void DominationResolver::eliminateDominatedOperations(Position& newPos) {
         }
     }
 }
+
+void DominationResolver::getBucketKey(const USignature& op, std::vector<int>& mask, std::vector<int>& key, 
+        FlatHashMap<IntPair, int, IntPairHasher>& originIds) {
+    
+    mask.resize(op._args.size());
+    key.resize(op._args.size());
+    for (size_t argIdx = 0; argIdx < op._args.size(); argIdx++) {
+        int arg = op._args[argIdx];
+        if (_htn.isQConstant(arg)) {
+            const auto& origin = _htn.getOriginOfQConstant(arg);
+            auto it = originIds.find(origin);
+            if (it == originIds.end()) it = originIds.emplace(origin, originIds.size()).first;
+            mask[argIdx] = 1;
+            key[argIdx] = -1-it->second;
+        } else {
+            mask[argIdx] = 0;
+            key[argIdx] = arg;
+        }
+    }
+}
+
+bool DominationResolver::areBucketsCompatible(const std::vector<int>& key, const std::vector<int>& otherKey) {
+    for (size_t argIdx = 0; argIdx < key.size(); argIdx++) {
+        // Two different constants or two q-constants of different origins
+        if ((key[argIdx] < 0) == (otherKey[argIdx] < 0) && key[argIdx] != otherKey[argIdx]) 
+            return false;
+    }
+    return true;
+}
+
+int DominationResolver::getDomainId(int qconst) {
+    auto it = _domain_id_of_qconst.find(qconst);
+    if (it != _domain_id_of_qconst.end()) return it->second;
+
+    const auto& domain = _htn.getDomainOfQConstant(qconst);
+    std::vector<int> sortedDomain(domain.begin(), domain.end());
+    std::sort(sortedDomain.begin(), sortedDomain.end());
+    int id;
+    auto idIt = _domain_ids.find(sortedDomain);
+    if (idIt != _domain_ids.end()) id = idIt->second;
+    else {
+        id = _domain_representatives.size();
+        _domain_ids[std::move(sortedDomain)] = id;
+        _domain_representatives.push_back(qconst);
+    }
+    _domain_id_of_qconst[qconst] = id;
+    return id;
+}
+
+bool DominationResolver::isSubdomain(int subId, int superId) {
+    if (subId == superId) return true;
+
+    IntPair pair(subId, superId);
+    auto it = _subdomain_cache.find(pair);
+    if (it != _subdomain_cache.end()) return it->second;
+
+    const auto& subDomain = _htn.getDomainOfQConstant(_domain_representatives[subId]);
+    const auto& superDomain = _htn.getDomainOfQConstant(_domain_representatives[superId]);
+    bool subset = subDomain.size() <= superDomain.size();
+    if (subset) for (int c : subDomain) if (!superDomain.count(c)) {
+        subset = false;
+        break;
+    }
+    _subdomain_cache[pair] = subset;
+    return subset;
+}
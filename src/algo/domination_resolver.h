@@ -4,6 +4,7 @@
 
 #include "data/htn_instance.h"
 #include "data/position.h"
+#include "util/hashmap.h"
 
 class DominationResolver {
 
@@ -12,6 +13,17 @@ private:
 
     size_t _num_dominated_ops = 0;
 
+    // Interned q-constant domains: Equal domains share the same ID
+    FlatHashMap<int, int> _domain_id_of_qconst;
+    NodeHashMap<std::vector<int>, int, IntVecHasher> _domain_ids;
+    std::vector<int> _domain_representatives;
+    FlatHashMap<IntPair, bool, IntPairHasher> _subdomain_cache;
+
+    // Statistics on the domination checks avoided by bucketing
+    size_t _num_domination_checks = 0;
+    size_t _num_skipped_domination_checks = 0;
+    double _domination_check_time = 0;
+
 public:
     DominationResolver(HtnInstance& htn) : _htn(htn) {}
 
@@ -27,6 +39,46 @@ public:
     size_t getNumDominatedOps() const {
         return _num_dominated_ops;
     }
+    size_t getNumDominationChecks() const {
+        return _num_domination_checks;
+    }
+    size_t getNumSkippedDominationChecks() const {
+        return _num_skipped_domination_checks;
+    }
+    // Drops the interned q-constant domains and memoized subdomain tests 
+    // and returns the number of dropped entries
+    size_t clearCache() {
+        size_t size = _domain_id_of_qconst.size() + _domain_ids.size() + _subdomain_cache.size();
+        _domain_id_of_qconst.clear();
+        _domain_id_of_qconst.reserve(0);
+        _domain_ids.clear();
+        _domain_ids.reserve(0);
+        _domain_representatives.clear();
+        _domain_representatives.shrink_to_fit();
+        _subdomain_cache.clear();
+        _subdomain_cache.reserve(0);
+        return size;
+    }
+    // Estimate of the time which the skipped checks would have taken
+    double getEstimatedTimeSaved() const {
+        if (_num_domination_checks == 0) return 0;
+        return _domination_check_time / _num_domination_checks * _num_skipped_domination_checks;
+    }
+
+private:
+    // Ops of a name can only relate to each other if they agree on all positions
+    // where both have a ground constant resp. both have a q-constant of the same origin.
+    // The key of an op encodes, for each argument, the constant (>= 0) or the origin of the q-constant (< 0);
+    // the mask marks the q-constant positions.
+    typedef NodeHashMap<std::vector<int>, std::vector<USignature>, IntVecHasher> BucketsByKey;
+    typedef NodeHashMap<std::vector<int>, BucketsByKey, IntVecHasher> BucketsByMask;
+
+    void getBucketKey(const USignature& op, std::vector<int>& mask, std::vector<int>& key, 
+            FlatHashMap<IntPair, int, IntPairHasher>& originIds);
+    bool areBucketsCompatible(const std::vector<int>& key, const std::vector<int>& otherKey);
+
+    int getDomainId(int qconst);
+    bool isSubdomain(int subId, int superId);
 };
 
 #endif
\ No newline at end of file
@@ -31,6 +31,9 @@ private:
 
     NodeHashMap<int, FactFrame> _fact_frames;
 
+    // Incremented whenever the set of reachable facts changes.
+    size_t _reachability_epoch = 0;
+
 public:
     
     FactAnalysis(HtnInstance& htn) : _htn(htn), _traversal(htn), _init_state(_htn.getInitState()) {
@@ -41,6 +44,7 @@ public:
         _pos_layer_facts = _init_state;
         _neg_layer_facts.clear();
         _initialized_facts.clear();
+        _reachability_epoch++;
     }
 
     void addReachableFact(const Signature& fact) {
@@ -48,7 +52,12 @@ public:
     }
 
     void addReachableFact(const USignature& fact, bool negated) {
-        (negated ? _neg_layer_facts : _pos_layer_facts).insert(fact);
+        if ((negated ? _neg_layer_facts : _pos_layer_facts).insert(fact).second)
+            _reachability_epoch++;
+    }
+
+    size_t getReachabilityEpoch() const {
+        return _reachability_epoch;
     }
 
     bool isReachable(const Signature& fact) {
@@ -84,6 +93,7 @@ public:
 
     void addInitializedFact(const USignature& fact) {
         _initialized_facts.insert(fact);
+        // (Does not change reachability: the fact is already reachable if inserted)
         if (isReachable(fact, /*negated=*/true)) {
             _neg_layer_facts.insert(fact);
         }
@@ -98,6 +108,13 @@ public:
     const SigSet& getPossibleFactChanges(const USignature& sig, FactInstantiationMode mode = FULL, OperationType opType = UNKNOWN);
 
     void eraseCachedPossibleFactChanges(const USignature& sig);
+    // Drops all cached fact changes and returns the number of dropped entries
+    size_t clearFactChangesCache() {
+        size_t size = _fact_changes_cache.size();
+        _fact_changes_cache.clear();
+        _fact_changes_cache.reserve(0);
+        return size;
+    }
 
     SigSet inferPreconditions(const USignature& op) {
         static USigSet EMPTY_USIG_SET;
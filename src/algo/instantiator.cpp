@@ -2,29 +2,57 @@
 #include <assert.h>
 #include <set>
 #include <algorithm>
+#include <thread>
+#include <cstdint>
 
 #include "algo/instantiator.h"
 #include "algo/arg_iterator.h"
 #include "data/htn_instance.h"
 #include "util/names.h"
+#include "util/trace.h"
 
 USigSet Instantiator::EMPTY_USIG_SET;
 
 std::vector<USignature> Instantiator::getApplicableInstantiations(const Reduction& r, int mode) {
-
-    int oldMode = _inst_mode;
-    if (mode >= 0) _inst_mode = mode;
-    auto result = instantiate(r);
-    _inst_mode = oldMode;
-
-    return result;
+    return instantiateCached(r, mode);
 }
 
 std::vector<USignature> Instantiator::getApplicableInstantiations(const Action& a, int mode) {
+    return instantiateCached(a, mode);
+}
+
+std::vector<USignature> Instantiator::instantiateCached(const HtnOp& op, int mode) {
 
     int oldMode = _inst_mode;
     if (mode >= 0) _inst_mode = mode;
-    auto result = instantiate(a);
+
+    if (!_use_cache) {
+        auto result = instantiate(op);
+        _inst_mode = oldMode;
+        return result;
+    }
+
+    // The instantiations of an operator only depend on its signature,
+    // the instantiation mode and the set of currently reachable facts:
+    // Invalidate all memoized results whenever reachability changed
+    size_t epoch = _analysis.getReachabilityEpoch();
+    if (epoch != _cache_epoch) {
+        for (auto& cache : _cache) cache.clear();
+        _cache_epoch = epoch;
+    }
+
+    auto& cache = _cache[_inst_mode];
+    USignature sig = op.getSignature();
+    auto it = cache.find(sig);
+    if (it != cache.end()) {
+        _num_cache_hits++;
+        _inst_mode = oldMode;
+        return it->second;
+    }
+
+    _num_cache_misses++;
+    auto result = instantiate(op);
+    cache[sig] = result;
     _inst_mode = oldMode;
 
     return result;
@@ -54,27 +82,29 @@ struct CompArgs {
 std::vector<USignature> Instantiator::instantiate(const HtnOp& op) {
     __op = &op;
 
-    /*
-    // First try to naively ground the operation up to some limit
-    FlatHashSet<int> argsToInstantiate;
-    if (_inst_mode == INSTANTIATE_FULL) {
-        for (const int& arg : op.getArguments()) {
-            if (_htn->isVariable(arg)) argsToInstantiate.insert(arg);
-        }
-    }
-    std::vector<int> argsByPriority(argsToInstantiate.begin(), argsToInstantiate.end());
-    std::sort(argsByPriority.begin(), argsByPriority.end(), CompArgs());
-    */
+    // Collect the indices of all variable args to instantiate according to the q-constant policy
     std::vector<int> argIndicesByPriority;
-    /*
-    const auto& sorts = _htn.getSorts(op.getSignature()._name_id);
-    for (size_t i = 0; i < sorts.size(); i++) {
-        int arg = op.getArguments()[i];
-        if (_htn.isVariable(arg) && _htn.getConstantsOfSort(sorts[i]).size() == 1) {
-            // Argument is trivial: insert only possible constant
-            argIndicesByPriority.push_back(i); 
+    if (_inst_mode != INSTANTIATE_NOTHING) {
+        for (size_t i = 0; i < op.getArguments().size(); i++) {
+            const int& arg = op.getArguments().at(i);
+            if (!_htn.isVariable(arg)) continue;
+
+            bool found = _inst_mode == INSTANTIATE_FULL;
+            for (const auto& pre : op.getPreconditions()) {
+                if (found) break;
+                for (const int& preArg : pre._usig._args) if (arg == preArg) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) argIndicesByPriority.push_back(i);
         }
-    }*/
+        // Sort args to instantiate by their priority descendingly
+        CompArgs comp;
+        std::stable_sort(argIndicesByPriority.begin(), argIndicesByPriority.end(), [&](int i, int j) {
+            return comp(op.getArguments()[i], op.getArguments()[j]);
+        });
+    }
 
     // a) Try to naively ground _one single_ instantiation
     // -- if this fails, there is no valid instantiation at all
@@ -89,60 +119,6 @@ std::vector<USignature> Instantiator::instantiate(const HtnOp& op) {
     }
     
     return instantiateLimited(op, argIndicesByPriority, 0, false);
-
-    /*
-    // Collect all arguments which should be instantiated
-    FlatHashSet<int> argsToInstantiate;
-
-    // a) All variable args according to the q-constant policy
-    for (size_t i = 0; i < op.getArguments().size(); i++) {
-        const int& arg = op.getArguments().at(i);
-        if (!_htn->isVariable(arg)) continue;
-
-        if (_inst_mode == INSTANTIATE_FULL) {
-
-            argsToInstantiate.insert(arg);
-
-        } else if (_inst_mode == INSTANTIATE_PRECONDITIONS) {
-    
-            bool found = false;
-            for (const auto& pre : op.getPreconditions()) {
-                for (const int& preArg : pre._usig._args) {
-                    if (arg == preArg) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (found) break;
-            }
-
-            if (found) argsToInstantiate.insert(arg);
-        }
-    }
-
-    // b) All variable args whose domain is below the specified q constant threshold
-    if (_q_const_rating_factor > 0) {
-        const auto& ratings = getPreconditionRatings(op.getSignature());
-        if (_inst_mode != INSTANTIATE_FULL)
-        for (size_t argIdx = 0; argIdx < op.getArguments().size(); argIdx++) {
-            int arg = op.getArguments().at(argIdx);
-            if (!_htn->isVariable(arg)) continue;
-
-            int sort = _htn->getSorts(op.getNameId()).at(argIdx);
-            int domainSize = _htn->getConstantsOfSort(sort).size();
-            float r = ratings.at(arg);
-            if (_q_const_rating_factor*r > domainSize) {
-                argsToInstantiate.insert(arg);
-            }
-        }
-    }
-
-    // Sort args to instantiate by their priority descendingly
-    argsByPriority = std::vector<int>(argsToInstantiate.begin(), argsToInstantiate.end());
-    std::sort(argsByPriority.begin(), argsByPriority.end(), CompArgs());
-
-    return instantiateLimited(op, state, argsByPriority, 0, false);
-    */
 }
 
 std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
@@ -161,6 +137,72 @@ std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const
         return instantiation;
     }
 
+    // Domains of all arguments to instantiate, in the order of instantiation
+    std::vector<std::vector<int>> domains;
+    size_t numCandidates = 1;
+    for (int argPos : argIndicesByPriority) {
+        int sort = _htn.getSorts(op.getNameId()).at(argPos);
+        const auto& constants = _htn.getConstantsOfSort(sort);
+        domains.emplace_back(constants.begin(), constants.end());
+        numCandidates = (constants.empty() || numCandidates <= SIZE_MAX / constants.size()) ? 
+                numCandidates * constants.size() : SIZE_MAX;
+    }
+
+    // Full instantiation of a large candidate space: distribute it over several threads
+    if (limit == 0 && _par_inst_threshold > 0 && numCandidates >= _par_inst_threshold 
+            && _num_inst_threads > 1 && domains[0].size() > 1) {
+        _num_parallel_instantiations++;
+        return instantiateInParallel(op, argIndicesByPriority, domains);
+    }
+
+    bool limitExceeded = instantiateDomains(op, argIndicesByPriority, domains, limit, returnUnfinished, instantiation);
+    if (limitExceeded && !returnUnfinished) {
+        // Limit exceeded -- return failure
+        return std::vector<USignature>();
+    }
+
+    //log("INST %s : %i instantiations\n", TOSTR(op.getSignature()), instantiation.size());
+    return instantiation;
+}
+
+std::vector<USignature> Instantiator::instantiateInParallel(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
+        const std::vector<std::vector<int>>& domains) {
+
+    // Partition the domain of the first argument into contiguous slices, one per thread
+    size_t numSlices = std::min(_num_inst_threads, domains[0].size());
+    std::vector<std::vector<USignature>> results(numSlices);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numSlices; t++) {
+        threads.emplace_back([&, t]() {
+            TRACE_SCOPE("parallel instantiation");
+            size_t begin = t * domains[0].size() / numSlices;
+            size_t end = (t+1) * domains[0].size() / numSlices;
+            std::vector<std::vector<int>> slicedDomains(domains);
+            slicedDomains[0] = std::vector<int>(domains[0].begin()+begin, domains[0].begin()+end);
+            instantiateDomains(op, argIndicesByPriority, slicedDomains, 0, false, results[t]);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // Concatenate the results in the order of the sequential enumeration, independent of the number of slices:
+    // It emits the instantiations of a single argument in domain order, but otherwise explores
+    // the assignments of the first argument last-to-first (each one completely)
+    bool reverse = argIndicesByPriority.size() > 1;
+    std::vector<USignature> instantiation;
+    for (size_t i = 0; i < numSlices; i++) {
+        auto& result = results[reverse ? numSlices-1-i : i];
+        instantiation.insert(instantiation.end(), 
+                std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
+    }
+    return instantiation;
+}
+
+bool Instantiator::instantiateDomains(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
+        const std::vector<std::vector<int>>& domains, size_t limit, bool returnUnfinished, 
+        std::vector<USignature>& instantiation) const {
+
+    // Must not modify any shared state: may be executed by several threads concurrently
+    size_t doneInstSize = argIndicesByPriority.size();
     std::vector<std::vector<int>> assignmentsStack;
     assignmentsStack.push_back(std::vector<int>()); // begin with empty assignment
     while (!assignmentsStack.empty()) {
@@ -169,9 +211,7 @@ std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const
         //for (int a : assignment) log("%i ", a); log("\n");
 
         // Loop over possible choices for the next argument position
-        int argPos = argIndicesByPriority[assignment.size()];
-        int sort = _htn.getSorts(op.getNameId()).at(argPos);
-        for (int c : _htn.getConstantsOfSort(sort)) {
+        for (int c : domains[assignment.size()]) {
 
             // Create new assignment
             std::vector<int> newAssignment(assignment);
@@ -203,12 +243,12 @@ std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const
 
                 if (limit > 0) {
                     if (returnUnfinished && instantiation.size() == limit) {
-                        // Limit exceeded -- return unfinished instantiation
-                        return instantiation;
+                        // Limit reached -- return unfinished instantiation
+                        return true;
                     }
                     if (!returnUnfinished && instantiation.size() > limit) {
                         // Limit exceeded -- return failure
-                        return std::vector<USignature>();
+                        return true;
                     }
                 }
 
@@ -218,11 +258,7 @@ std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const
             }
         }
     }
-
-    __op = NULL;
-
-    //log("INST %s : %i instantiations\n", TOSTR(op.getSignature()), instantiation.size());
-    return instantiation;
+    return false;
 }
 
 const FlatHashMap<int, float>& Instantiator::getPreconditionRatings(const USignature& opSig) {
@@ -3,6 +3,8 @@
 #define DOMPASCH_TREE_REXX_INSTANTIATOR_H
 
 #include <functional>
+#include <thread>
+#include <algorithm>
 
 #include "data/htn_instance.h"
 #include "util/hashmap.h"
@@ -56,9 +58,22 @@ private:
 
     NodeHashMap<int, FlatHashMap<int, float>> _precond_ratings;
 
+    // Memoized instantiations per instantiation mode, valid for a single reachability epoch
+    const bool _use_cache;
+    size_t _cache_epoch = -1;
+    NodeHashMap<USignature, std::vector<USignature>, USignatureHasher> _cache[3];
+    size_t _num_cache_hits = 0;
+    size_t _num_cache_misses = 0;
+
+    // Full instantiations with at least this many candidates are computed by several threads
+    size_t _par_inst_threshold;
+    size_t _num_inst_threads;
+    size_t _num_parallel_instantiations = 0;
+
 public:
     Instantiator(Parameters& params, HtnInstance& htn, FactAnalysis& analysis) : 
-            _params(params), _htn(htn), _analysis(analysis), _traversal(htn) {
+            _params(params), _htn(htn), _analysis(analysis), _traversal(htn), 
+            _use_cache(_params.isNonzero("ic")) {
         
         if (_params.isNonzero("qq")) {
             _inst_mode = INSTANTIATE_NOTHING;
@@ -69,15 +84,39 @@ public:
         }
         _q_const_rating_factor = _params.getFloatParam("qrf");
         _q_const_instantiation_limit = _params.getIntParam("qit");
+        _par_inst_threshold = std::max(0, _params.getIntParam("pit"));
+        int numThreads = _params.getIntParam("ith");
+        _num_inst_threads = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
     }
 
     std::vector<USignature> getApplicableInstantiations(const Reduction& r, int mode = -1);
     std::vector<USignature> getApplicableInstantiations(const Action& a, int mode = -1);
 
+    size_t getNumCacheHits() const {return _num_cache_hits;}
+    size_t getNumCacheMisses() const {return _num_cache_misses;}
+    size_t getNumParallelInstantiations() const {return _num_parallel_instantiations;}
+
+    // Drops all memoized instantiations and returns the number of dropped entries
+    size_t clearCache() {
+        size_t size = 0;
+        for (auto& cache : _cache) {
+            size += cache.size();
+            cache.clear();
+            cache.reserve(0);
+        }
+        return size;
+    }
+
 private:
+    std::vector<USignature> instantiateCached(const HtnOp& op, int mode);
     std::vector<USignature> instantiate(const HtnOp& op);
     std::vector<USignature> instantiateLimited(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
             size_t limit, bool returnUnfinished);
+    std::vector<USignature> instantiateInParallel(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
+            const std::vector<std::vector<int>>& domains);
+    bool instantiateDomains(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
+            const std::vector<std::vector<int>>& domains, size_t limit, bool returnUnfinished, 
+            std::vector<USignature>& instantiation) const;
     
     const FlatHashMap<int, float>& getPreconditionRatings(const USignature& opSig);
 };
@@ -0,0 +1,75 @@
+
+#include <stdlib.h>
+
+#include "algo/memory_budget.h"
+#include "util/memusage.h"
+#include "util/log.h"
+
+MemoryBudget::MemoryBudget(Parameters& params, std::vector<Layer*>& layers, FactAnalysis& analysis, Instantiator& instantiator, 
+            DominationResolver& dominationResolver) :
+        _layers(layers), _analysis(analysis), _instantiator(instantiator), _domination_resolver(dominationResolver),
+        _budget_kb(1024.0 * params.getFloatParam("mb")), _spill_directory(params.getParam("mbd", "")) {
+
+    if (_spill_directory.empty()) {
+        const char* tmpdir = getenv("TMPDIR");
+        _spill_directory = tmpdir != nullptr ? tmpdir : "/tmp";
+    }
+}
+
+void MemoryBudget::check(size_t layerIdx) {
+    if (!isActive()) return;
+
+    double vm, rss;
+    process_mem_usage(vm, rss);
+    _peak_rss_kb = std::max(_peak_rss_kb, rss);
+
+    // Intervene at most once per layer: dropping the caches at each check
+    // would discard the instantiations memoized for the current layer over and over
+    if (rss >= CRITICAL_FRACTION * _budget_kb && (int)layerIdx != _last_intervention_layer) {
+        _last_intervention_layer = layerIdx;
+        _num_interventions++;
+        if (_level < SPILL_PAST_LAYERS) {
+            _level++;
+            Log::i("Memory budget: RSS of %.0f MB exceeds %.0f%% of %.0f MB - escalating to level %i\n",
+                rss / 1024, 100*CRITICAL_FRACTION, _budget_kb / 1024, _level);
+        }
+        // Caches fill up again, so they are dropped each time the budget is critical
+        dropCaches();
+    }
+
+    // Keep up with newly finished layers
+    if (_level >= SPILL_PAST_LAYERS) spillPastLayers(layerIdx);
+}
+
+void MemoryBudget::dropCaches() {
+    size_t factChanges = _analysis.clearFactChangesCache();
+    size_t instantiations = _instantiator.clearCache();
+    size_t domains = _domination_resolver.clearCache();
+    _num_dropped_cache_entries += factChanges + instantiations + domains;
+    Log::i("Memory budget: dropped %i cached fact changes, %i cached instantiations and %i cached q-constant domains\n",
+        factChanges, instantiations, domains);
+}
+
+void MemoryBudget::spillPastLayers(size_t layerIdx) {
+    if (layerIdx < 2 || _num_spilled_layers >= layerIdx-1) return;
+    if (!_spill_file.isOpen() && !_spill_file.open(_spill_directory)) {
+        // Cannot spill anything: do not try again
+        _num_spilled_layers = (size_t)-1;
+        return;
+    }
+    size_t numPositions = 0;
+    size_t numBytes = 0;
+    for (size_t l = _num_spilled_layers; l+1 < layerIdx; l++) {
+        Layer& layer = *_layers.at(l);
+        for (size_t pos = 0; pos < layer.size(); pos++) {
+            size_t bytes = layer[pos].spillOpVariables(_spill_file);
+            if (bytes > 0) numPositions++;
+            numBytes += bytes;
+        }
+    }
+    Log::i("Memory budget: spilled operation variables of %i positions of layers %i..%i (%.1f MB)\n",
+        numPositions, _num_spilled_layers, layerIdx-2, numBytes / 1024.0 / 1024.0);
+    _num_spilled_layers = layerIdx-1;
+    _num_spilled_positions += numPositions;
+    _num_spilled_bytes += numBytes;
+}
@@ -0,0 +1,73 @@
+
+#ifndef DOMPASCH_LILOTANE_MEMORY_BUDGET_H
+#define DOMPASCH_LILOTANE_MEMORY_BUDGET_H
+
+#include <vector>
+
+#include "data/layer.h"
+#include "algo/fact_analysis.h"
+#include "algo/instantiator.h"
+#include "algo/domination_resolver.h"
+#include "util/params.h"
+#include "util/spill_file.h"
+
+/*
+Keeps the resident memory of the planner below a given budget by degrading step by step
+whenever the RSS comes close to the budget (see CRITICAL_FRACTION):
+  1. drop caches (fact changes, memoized instantiations, q-constant domains),
+  2. spill the operation variables of finished layers, which are only needed for
+     decoding and retroactive pruning, to a memory-mapped file.
+(All other contents of finished positions are already cleared incrementally.)
+The budget intervenes at most once per layer. Once a level is reached, it remains
+active for all subsequently finished layers.
+*/
+class MemoryBudget {
+
+private:
+    std::vector<Layer*>& _layers;
+    FactAnalysis& _analysis;
+    Instantiator& _instantiator;
+    DominationResolver& _domination_resolver;
+
+    // Budget in kB (0: no budget)
+    double _budget_kb;
+    std::string _spill_directory;
+    SpillFile _spill_file;
+
+    enum Level {NONE = 0, DROP_CACHES = 1, SPILL_PAST_LAYERS = 2};
+    int _level = NONE;
+    int _last_intervention_layer = -1;
+    // All layers below this index have been spilled
+    size_t _num_spilled_layers = 0;
+
+    // statistics
+    double _peak_rss_kb = 0;
+    size_t _num_interventions = 0;
+    size_t _num_dropped_cache_entries = 0;
+    size_t _num_spilled_positions = 0;
+    size_t _num_spilled_bytes = 0;
+
+public:
+    static constexpr double CRITICAL_FRACTION = 0.9;
+
+    MemoryBudget(Parameters& params, std::vector<Layer*>& layers, FactAnalysis& analysis, Instantiator& instantiator, 
+            DominationResolver& dominationResolver);
+
+    bool isActive() const {return _budget_kb > 0;}
+
+    // Checks the current memory usage and reacts if necessary.
+    // layerIdx is the layer currently being instantiated or encoded.
+    void check(size_t layerIdx);
+
+    double getPeakRssKb() const {return _peak_rss_kb;}
+    size_t getNumInterventions() const {return _num_interventions;}
+    size_t getNumDroppedCacheEntries() const {return _num_dropped_cache_entries;}
+    size_t getNumSpilledPositions() const {return _num_spilled_positions;}
+    size_t getNumSpilledBytes() const {return _num_spilled_bytes;}
+
+private:
+    void dropCaches();
+    void spillPastLayers(size_t layerIdx);
+};
+
+#endif
@@ -14,9 +14,10 @@ private:
     FlatHashMap<int, int> _min_recursive_expansion_sizes;
 
 public:
-    MinRES(HtnInstance& htn) : _htn(htn) {
-        //computeMinNumPrimitiveChildren();
-    }
+    static constexpr int INFINITE_SIZE = 1 << 29;
+
+    // The sizes of reductions are only available after computeMinNumPrimitiveChildren()
+    MinRES(HtnInstance& htn) : _htn(htn) {}
 
     int getMinNumPrimitiveChildren(int sigName) {
         
@@ -36,11 +37,17 @@ public:
     void computeMinNumPrimitiveChildren() {
 
         for (const auto& [nameId, action] : _htn.getActionTemplates()) {
-            Log::d("%s : MinRES = %i\n", TOSTR(action.getSignature()), 
+            LOG_D("%s : MinRES = %i\n", TOSTR(action.getSignature()), 
                 getMinNumPrimitiveChildren(nameId));
         }
 
         NetworkTraversal nt(_htn);
+
+        // Fixed point iteration from above: reductions which can never 
+        // be expanded into a finite network keep an infinite size
+        for (const auto& [nameId, reduction] : _htn.getReductionTemplates()) {
+            _min_recursive_expansion_sizes[nameId] = INFINITE_SIZE;
+        }
         
         bool change = true;
         size_t numPasses = 0;
@@ -48,44 +55,32 @@ public:
             change = false;
             for (const auto& [nameId, reduction] : _htn.getReductionTemplates()) {
 
-                if (_min_recursive_expansion_sizes.count(nameId)) continue;
-
-                bool canComputeMinRes = true;
-                for (const auto& sig : nt.getPossibleChildren(reduction.getSignature())) {
-                    if (sig._name_id != nameId && !_min_recursive_expansion_sizes.count(sig._name_id)) {
-                        canComputeMinRes = false;
-                        break;
-                    }
-                }
-                if (!canComputeMinRes) continue;
-
-                std::vector<int> args(_htn.getSorts(nameId).size(), -1);
-                USignature normSig(nameId, args);
-                int& minNumChildren = _min_recursive_expansion_sizes[nameId];
+                int minNumChildren = 0;
                 const auto& r = _htn.getReductionTemplate(nameId);
-                for (size_t o = 0; o < r.getSubtasks().size(); o++) {
-                    int minNumChildrenAtO = 999999;
+                for (size_t o = 0; o < r.getSubtasks().size() && minNumChildren < INFINITE_SIZE; o++) {
+                    int minNumChildrenAtO = INFINITE_SIZE;
 
                     std::vector<USignature> children;
                     nt.getPossibleChildren(r.getSubtasks(), o, children);
-                    FlatHashSet<int> childrenIds;
-                    for (const auto& child : children) 
-                        if (child._name_id != nameId) childrenIds.insert(child._name_id);
-                    for (const auto& child : childrenIds) {
-                        minNumChildrenAtO = std::min(minNumChildrenAtO, getMinNumPrimitiveChildren(child));
+                    for (const auto& child : children) {
+                        minNumChildrenAtO = std::min(minNumChildrenAtO, getMinNumPrimitiveChildren(child._name_id));
                     }
-
-                    assert(minNumChildrenAtO < 999999);
-                    minNumChildren += minNumChildrenAtO;
+                    minNumChildren = std::min(INFINITE_SIZE, minNumChildren + minNumChildrenAtO);
                 }
 
-                Log::d("%s : MinRES = %i\n", TOSTR(reduction.getSignature()), 
-                    getMinNumPrimitiveChildren(nameId));
-                
-                change = true;
+                if (minNumChildren < _min_recursive_expansion_sizes[nameId]) {
+                    _min_recursive_expansion_sizes[nameId] = minNumChildren;
+                    change = true;
+                }
             }
             numPasses++;
         }
+
+        for (const auto& [nameId, reduction] : _htn.getReductionTemplates()) {
+            LOG_D("%s : MinRES = %i\n", TOSTR(reduction.getSignature()), 
+                getMinNumPrimitiveChildren(nameId));
+        }
+        Log::v("MinRES computed in %i passes\n", numPasses);
     }
 };
 
@@ -0,0 +1,258 @@
+
+#include <functional>
+
+#include "algo/plan_verifier.h"
+#include "util/log.h"
+
+bool PlanVerifier::verify(const Plan& plan) {
+
+    if (!_initialized) init();
+    _num_errors = 0;
+
+    // Method preconditions are checked before the first action below each method
+    std::vector<std::vector<const PlanItem*>> reductionsByFirstPos(plan.first.size()+1);
+    checkDecomposition(plan, reductionsByFirstPos);
+    checkExecution(plan, reductionsByFirstPos);
+
+    if (_num_errors > 0) {
+        Log::e("Plan verification failed with %i errors\n", _num_errors);
+        return false;
+    }
+    return true;
+}
+
+void PlanVerifier::init() {
+    for (const USignature& fact : _htn.getInitState()) {
+        int id = getFactId(fact);
+        if (id >= (int)_init_state.size()) _init_state.resize(id+1);
+        _init_state[id] = true;
+    }
+    _goal_action_name = _htn.nameId("<goal_action>");
+    _init_reduction_sig = _htn.getInitReduction().getSignature();
+    _initialized = true;
+}
+
+void PlanVerifier::checkDecomposition(const Plan& plan, std::vector<std::vector<const PlanItem*>>& reductionsByFirstPos) {
+
+    const auto& [classicalPlan, decomposition] = plan;
+
+    // Index actions (except for blank and goal actions) and reductions by their ID
+    FlatHashMap<int, size_t> actionPositions;
+    for (size_t pos = 0; pos < classicalPlan.size(); pos++) {
+        const PlanItem& item = classicalPlan[pos];
+        if (item.id < 0 || item.abstractTask == _htn.getBlankActionSig()) continue;
+        if (item.abstractTask._name_id == _goal_action_name) continue;
+        actionPositions[item.id] = pos;
+    }
+    FlatHashMap<int, const PlanItem*> reductions;
+    const PlanItem* root = nullptr;
+    for (const PlanItem& item : decomposition) {
+        if (item.id < 0) continue;
+        if (reductions.count(item.id) || actionPositions.count(item.id)) {
+            if (fail()) Log::e("Plan item ID %i occurs multiple times\n", item.id);
+            continue;
+        }
+        if (item.id == 0) root = &item;
+        reductions[item.id] = &item;
+    }
+    if (root == nullptr) {
+        if (fail()) Log::e("No root of the decomposition\n");
+    } else if (root->reduction._name_id != _init_reduction_sig._name_id) {
+        // (The initial reduction may be instantiated with any arguments)
+        if (fail()) Log::e("Root is decomposed with %s instead of the initial reduction\n", TOSTR(root->reduction));
+    }
+
+    // First and last position of the actions below each plan item
+    FlatHashMap<int, IntPair> spans;
+    std::function<IntPair(int)> getSpan = [&](int id) -> IntPair {
+        auto aIt = actionPositions.find(id);
+        if (aIt != actionPositions.end()) return IntPair(aIt->second, aIt->second);
+        auto sIt = spans.find(id);
+        if (sIt != spans.end()) return sIt->second;
+        // Mark as visited beforehand to be safe against cycles
+        spans[id] = IntPair(-1, -1);
+        IntPair span(-1, -1);
+        auto rIt = reductions.find(id);
+        if (rIt != reductions.end()) for (int subId : rIt->second->subtaskIds) {
+            IntPair subSpan = getSpan(subId);
+            if (subSpan.first < 0) continue;
+            if (span.first < 0) span = subSpan;
+            else span = IntPair(std::min(span.first, subSpan.first), std::max(span.second, subSpan.second));
+        }
+        spans[id] = span;
+        return span;
+    };
+
+    FlatHashMap<int, int> numReferences;
+    FlatHashSet<int> invalidReductions;
+    for (const auto& [id, item] : reductions) {
+
+        const USignature& rSig = item->reduction;
+        if (!_htn.isReduction(rSig) || !isGround(rSig)) {
+            if (fail()) Log::e("Item %i: %s is not a ground reduction\n", id, TOSTR(rSig));
+            invalidReductions.insert(id);
+            continue;
+        }
+        Reduction r = _htn.toReduction(rSig._name_id, rSig._args);
+        if (item != root && r.getTaskSignature() != item->abstractTask) {
+            if (fail()) Log::e("Item %i: %s does not decompose task %s\n", id, TOSTR(rSig), TOSTR(item->abstractTask));
+        }
+
+        // Each subtask must match the method's subtask and come after its predecessor
+        const auto& subtasks = r.getSubtasks();
+        if (item->subtaskIds.size() != subtasks.size()) {
+            if (fail()) Log::e("Item %i: %s has %i subtasks, but %i are given\n",
+                    id, TOSTR(rSig), subtasks.size(), item->subtaskIds.size());
+        }
+        int lastPos = -1;
+        for (size_t i = 0; i < item->subtaskIds.size(); i++) {
+            int subId = item->subtaskIds[i];
+            numReferences[subId]++;
+            USignature task;
+            auto aIt = actionPositions.find(subId);
+            auto rIt = reductions.find(subId);
+            if (aIt != actionPositions.end()) {
+                task = getTaskOfAction(classicalPlan[aIt->second].abstractTask);
+            } else if (rIt != reductions.end()) {
+                task = rIt->second->abstractTask;
+            } else {
+                if (fail()) Log::e("Item %i: unknown subtask ID %i\n", id, subId);
+                continue;
+            }
+            if (i < subtasks.size() && task != subtasks[i]) {
+                if (fail()) Log::e("Item %i: subtask #%i is %s instead of %s\n", id, i, TOSTR(task), TOSTR(subtasks[i]));
+            }
+            IntPair span = getSpan(subId);
+            if (span.first < 0) continue;
+            if (span.first <= lastPos) {
+                if (fail()) Log::e("Item %i: subtask #%i (ID %i) is out of order\n", id, i, subId);
+            }
+            lastPos = span.second;
+        }
+    }
+
+    // Each reduction's preconditions are checked before the first action below it.
+    // A reduction without any actions below it is checked in the state where it is applied:
+    // after the actions of its preceding siblings, or where its parent is applied.
+    FlatHashSet<int> placed;
+    std::function<void(const PlanItem*, size_t)> place = [&](const PlanItem* item, size_t pos) {
+        if (placed.count(item->id)) return;
+        placed.insert(item->id);
+        if (!invalidReductions.count(item->id)) reductionsByFirstPos[pos].push_back(item);
+        size_t nextPos = pos;
+        for (int subId : item->subtaskIds) {
+            IntPair subSpan = getSpan(subId);
+            auto rIt = reductions.find(subId);
+            if (rIt != reductions.end()) place(rIt->second, subSpan.first >= 0 ? subSpan.first : nextPos);
+            if (subSpan.first >= 0) nextPos = subSpan.second+1;
+        }
+    };
+    if (root != nullptr) {
+        IntPair span = getSpan(root->id);
+        place(root, span.first >= 0 ? span.first : 0);
+    }
+    // Reductions outside of the tree (reported above)
+    for (const auto& [id, item] : reductions) {
+        IntPair span = getSpan(id);
+        if (!placed.count(id) && !invalidReductions.count(id) && span.first >= 0) 
+            reductionsByFirstPos[span.first].push_back(item);
+    }
+
+    // Each action and each reduction except for the root is a subtask of exactly one reduction
+    for (const auto& [id, pos] : actionPositions) {
+        auto it = numReferences.find(id);
+        int num = it == numReferences.end() ? 0 : it->second;
+        if (num != 1 && fail()) Log::e("Action %i (%s) is a subtask of %i reductions\n",
+                id, TOSTR(classicalPlan[pos].abstractTask), num);
+    }
+    for (const auto& [id, item] : reductions) {
+        if (item == root) continue;
+        auto it = numReferences.find(id);
+        int num = it == numReferences.end() ? 0 : it->second;
+        if (num != 1 && fail()) Log::e("Reduction %i (%s) is a subtask of %i reductions\n",
+                id, TOSTR(item->reduction), num);
+    }
+}
+
+void PlanVerifier::checkExecution(const Plan& plan, const std::vector<std::vector<const PlanItem*>>& reductionsByFirstPos) {
+
+    const auto& classicalPlan = plan.first;
+    std::vector<bool> state = _init_state;
+    bool goalChecked = false;
+
+    for (size_t pos = 0; pos < classicalPlan.size(); pos++) {
+
+        for (const PlanItem* item : reductionsByFirstPos[pos]) {
+            Reduction r = _htn.toReduction(item->reduction._name_id, item->reduction._args);
+            checkPreconditions(r.getPreconditions(), state, item->reduction, pos);
+        }
+
+        const PlanItem& item = classicalPlan[pos];
+        const USignature& aSig = item.abstractTask;
+        if (item.id < 0 || aSig == _htn.getBlankActionSig()) continue;
+        if (!_htn.isAction(aSig) || !isGround(aSig)) {
+            if (fail()) Log::e("Position %i: %s is not a ground action\n", pos, TOSTR(aSig));
+            continue;
+        }
+        Action a = _htn.toAction(aSig._name_id, aSig._args);
+        checkPreconditions(a.getPreconditions(), state, aSig, pos);
+        if (aSig._name_id == _goal_action_name) {
+            goalChecked = true;
+            continue;
+        }
+
+        // Apply effects: positive effects win over negative ones
+        for (const Signature& eff : a.getEffects()) if (eff._negated) {
+            int id = getFactId(eff._usig);
+            if (id < (int)state.size()) state[id] = false;
+        }
+        for (const Signature& eff : a.getEffects()) if (!eff._negated) {
+            int id = getFactId(eff._usig);
+            if (id >= (int)state.size()) state.resize(id+1);
+            state[id] = true;
+        }
+    }
+
+    // Reductions without actions after the last action
+    for (const PlanItem* item : reductionsByFirstPos[classicalPlan.size()]) {
+        Reduction r = _htn.toReduction(item->reduction._name_id, item->reduction._args);
+        checkPreconditions(r.getPreconditions(), state, item->reduction, classicalPlan.size());
+    }
+
+    if (!goalChecked && fail()) Log::e("Plan does not end with the goal action\n");
+}
+
+void PlanVerifier::checkPreconditions(const SigSet& pres, const std::vector<bool>& state, const USignature& op, size_t pos) {
+    for (const Signature& pre : pres) {
+        if (holds(pre._usig, state) == pre._negated && fail()) {
+            Log::e("Position %i: precondition %s of %s does not hold\n", pos, TOSTR(pre), TOSTR(op));
+        }
+    }
+}
+
+USignature PlanVerifier::getTaskOfAction(const USignature& aSig) {
+    // A primitivized reduction stands for the task which its reduction decomposes
+    if (_htn.isPrimitivization(aSig._name_id)) {
+        int reductionName = _htn.getReductionAndActionFromPrimitivization(aSig._name_id).first;
+        return _htn.toReduction(reductionName, aSig._args).getTaskSignature();
+    }
+    return aSig;
+}
+
+bool PlanVerifier::isGround(const USignature& sig) const {
+    for (int arg : sig._args) if (_htn.isVariable(arg) || _htn.isQConstant(arg)) return false;
+    return true;
+}
+
+bool PlanVerifier::holds(const USignature& fact, const std::vector<bool>& state) const {
+    auto it = _fact_ids.find(fact);
+    return it != _fact_ids.end() && it->second < (int)state.size() && state[it->second];
+}
+
+int PlanVerifier::getFactId(const USignature& fact) {
+    auto it = _fact_ids.find(fact);
+    if (it != _fact_ids.end()) return it->second;
+    int id = _fact_ids.size();
+    _fact_ids[fact] = id;
+    return id;
+}
@@ -0,0 +1,54 @@
+
+#ifndef DOMPASCH_LILOTANE_PLAN_VERIFIER_H
+#define DOMPASCH_LILOTANE_PLAN_VERIFIER_H
+
+#include <vector>
+
+#include "data/htn_instance.h"
+#include "data/plan.h"
+#include "util/hashmap.h"
+
+/*
+Verifies a decoded plan directly on the instance's name IDs, without converting it
+to the textual plan format:
+  - the decomposition forms a tree from the initial reduction whose methods decompose
+    the tasks they are applied to, with each subtask matching its method's subtask
+    in the correct order;
+  - every action and every method precondition is satisfied when the plan is executed
+    from the initial state, including the goal (as the preconditions of the goal action).
+States are bitsets over densely numbered ground facts.
+*/
+class PlanVerifier {
+
+private:
+    HtnInstance& _htn;
+
+    bool _initialized = false;
+    FlatHashMap<USignature, int, USignatureHasher> _fact_ids;
+    std::vector<bool> _init_state;
+    int _goal_action_name;
+    USignature _init_reduction_sig;
+
+    size_t _num_errors;
+
+public:
+    PlanVerifier(HtnInstance& htn) : _htn(htn) {}
+
+    bool verify(const Plan& plan);
+
+private:
+    void init();
+    void checkDecomposition(const Plan& plan, std::vector<std::vector<const PlanItem*>>& reductionsByFirstPos);
+    void checkExecution(const Plan& plan, const std::vector<std::vector<const PlanItem*>>& reductionsByFirstPos);
+    void checkPreconditions(const SigSet& pres, const std::vector<bool>& state, const USignature& op, size_t pos);
+
+    USignature getTaskOfAction(const USignature& aSig);
+    bool isGround(const USignature& sig) const;
+    bool holds(const USignature& fact, const std::vector<bool>& state) const;
+    int getFactId(const USignature& fact);
+
+    // Counts an error and tells whether it should still be reported
+    bool fail() {return ++_num_errors <= 10;}
+};
+
+#endif
@@ -4,9 +4,43 @@
 #include "verify.hpp"
 
 #include "algo/plan_writer.h"
+#include "util/timer.h"
 
 void PlanWriter::outputPlan(Plan& _plan) {
 
+    if (_params.isNonzero("nv")) {
+        // Verify plan natively (before it is altered by the conversion)
+        float time = Timer::elapsedSeconds();
+        if (!_verifier.verify(_plan)) {
+            Log::e("ERROR: Plan declared invalid by native verifier! Exiting.\n");
+            exit(1);
+        }
+        Log::v("Plan verified natively (%.4fs)\n", Timer::elapsedSeconds() - time);
+    }
+
+    size_t length;
+    std::string planStr = convertPlan(_plan, length);
+
+    if (_params.isNonzero("vp")) {
+        // Verify plan (by copying converted plan stream and putting it back into panda)
+        std::stringstream verifyStream;
+        verifyStream << planStr << std::endl;
+        bool ok = verify_plan(verifyStream, /*useOrderingInfo=*/true, /*lenientMode=*/false, /*debugMode=*/0);
+        if (!ok) {
+            Log::e("ERROR: Plan declared invalid by pandaPIparser! Exiting.\n");
+            exit(1);
+        }
+    }
+    
+    // Print plan
+    Log::log_notime(Log::V0_ESSENTIAL, planStr.c_str());
+    Log::log_notime(Log::V0_ESSENTIAL, "<==\n");
+    
+    Log::i("End of solution plan. (counted length of %i)\n", length);
+}
+
+std::string PlanWriter::convertPlan(Plan& _plan, size_t& length) {
+
     // Create stringstream which is being fed the plan
     std::stringstream stream;
 
@@ -20,7 +54,7 @@ void PlanWriter::outputPlan(Plan& _plan) {
     FlatHashSet<int> primitivizationIds;
     std::vector<PlanItem> decompsToInsert;
     size_t decompsToInsertIdx = 0;
-    size_t length = 0;
+    length = 0;
     
     for (PlanItem& item : std::get<0>(_plan)) {
 
@@ -97,22 +131,21 @@ void PlanWriter::outputPlan(Plan& _plan) {
     // (w.r.t. previous compilations the parser did)
     std::ostringstream outstream;
     convert_plan(stream, outstream);
-    std::string planStr = outstream.str();
+    return outstream.str();
+}
 
-    if (_params.isNonzero("vp")) {
-        // Verify plan (by copying converted plan stream and putting it back into panda)
-        std::stringstream verifyStream;
-        verifyStream << planStr << std::endl;
-        bool ok = verify_plan(verifyStream, /*useOrderingInfo=*/true, /*lenientMode=*/false, /*debugMode=*/0);
-        if (!ok) {
-            Log::e("ERROR: Plan declared invalid by pandaPIparser! Exiting.\n");
-            exit(1);
-        }
-    }
-    
-    // Print plan
-    Log::log_notime(Log::V0_ESSENTIAL, planStr.c_str());
-    Log::log_notime(Log::V0_ESSENTIAL, "<==\n");
-    
-    Log::i("End of solution plan. (counted length of %i)\n", length);
+void PlanWriter::streamPlan(const Plan& plan, int planLength, int layerIdx) {
+    if (!_anytime_output.isActive()) return;
+
+    // Conversion alters the plan: work on a copy
+    Plan copy = plan;
+    size_t length;
+    std::string planStr = convertPlan(copy, length) + "<==\n";
+
+    _anytime_output.begin("plan")
+        .add("plan_length", planLength)
+        .add("layer", layerIdx)
+        .add("plan", planStr.c_str())
+        .end();
+    Log::v("Streamed plan of length %i found at layer %i\n", planLength, layerIdx);
 }
@@ -7,16 +7,26 @@
 
 #include "data/htn_instance.h"
 #include "data/plan.h"
+#include "algo/plan_verifier.h"
+#include "util/metrics_sink.h"
 
 class PlanWriter {
 
 private:
     HtnInstance& _htn;
     Parameters& _params;
+    // Receives each improved plan as soon as it is found
+    MetricsSink _anytime_output;
+    PlanVerifier _verifier;
 
 public:
-    PlanWriter(HtnInstance& htn, Parameters& params) : _htn(htn), _params(params) {}
+    PlanWriter(HtnInstance& htn, Parameters& params) : _htn(htn), _params(params), 
+            _anytime_output(params.getParam("apf", "")), _verifier(htn) {}
     void outputPlan(Plan& _plan);
+    void streamPlan(const Plan& plan, int planLength, int layerIdx);
+
+private:
+    std::string convertPlan(Plan& _plan, size_t& length);
 };
 
 #endif
\ No newline at end of file
@@ -1,10 +1,13 @@
 
 #include <assert.h> 
+#include <algorithm>
 
 #include "planner.h"
 #include "util/log.h"
 #include "util/signal_manager.h"
 #include "util/timer.h"
+#include "util/memusage.h"
+#include "util/trace.h"
 #include "sat/plan_optimizer.h"
 
 int terminateSatCall(void* state) {return ((Planner*) state)->getTerminateSatCall();}
@@ -22,8 +25,10 @@ int Planner::findPlan() {
     _sat_time_limit = _params.getFloatParam("stl");
 
     bool solved = false;
+    bool satCalled = false;
     _enc.setTerminateCallback(this, terminateSatCall);
-    if (iteration >= firstSatCallIteration) {
+    if (iteration >= firstSatCallIteration && mayContainPlan()) {
+        satCalled = true;
         _enc.addAssumptions(_layer_idx);
         int result = _enc.solve();
         if (result == 0) {
@@ -36,20 +41,31 @@ int Planner::findPlan() {
     // Next layers
     while (!solved && (maxIterations == 0 || iteration < maxIterations)) {
 
-        if (iteration >= firstSatCallIteration) {
+        if (satCalled) {
 
             _enc.printFailedVars(*_layers.back());
 
-            if (_params.isNonzero("cs")) { // check solvability
+            if (_params.isNonzero("sle")) { // selective layer expansion
+                size_t numExpanded = _enc.deferExpansionsOutsideCore(*_layers.back());
+                Log::i("Expanding %i/%i positions of layer %i\n", numExpanded, _layers.back()->size(), _layer_idx);
+            }
+
+            // check solvability and/or find a near-solution to guide the next layer
+            if (_params.isNonzero("cs") || _enc.usesPhaseHints()) {
                 Log::i("Not solved at layer %i with assumptions\n", _layer_idx);
 
                 // Attempt to solve formula again, now without assumptions
-                // (is usually simple; if it fails, we know the entire problem is unsolvable)
+                // (is usually simple; if it fails, we know the entire problem is unsolvable).
+                // If the call is only made for phase hints, it may take at most
+                // as long as the call with assumptions did.
+                if (!_params.isNonzero("cs")) _hint_time_limit = std::max(_enc.getLastSatCallTime(), 0.001f);
                 int result = _enc.solve();
+                _hint_time_limit = 0;
                 if (result == 20) {
                     Log::w("Unsolvable at layer %i even without assumptions!\n", _layer_idx);
                     break;
                 } else {
+                    if (result == 10 && _enc.usesPhaseHints()) _enc.recordPhaseHints(_layer_idx);
                     Log::i("Not proven unsolvable - expanding by another layer\n");
                 }
             } else {
@@ -62,7 +78,8 @@ int Planner::findPlan() {
         
         createNextLayer();
 
-        if (iteration >= firstSatCallIteration) {
+        satCalled = iteration >= firstSatCallIteration && mayContainPlan();
+        if (satCalled) {
             _enc.addAssumptions(_layer_idx);
             int result = _enc.solve();
             if (result == 0) {
@@ -74,7 +91,7 @@ int Planner::findPlan() {
     }
 
     if (!solved) {
-        if (iteration >= firstSatCallIteration) _enc.printFailedVars(*_layers.back());
+        if (satCalled) _enc.printFailedVars(*_layers.back());
         Log::w("No success. Exiting.\n");
         return 1;
     }
@@ -84,15 +101,28 @@ int Planner::findPlan() {
 
     improvePlan(iteration);
 
-    _plan_writer.outputPlan(_plan);
+    outputPlan();
     printStatistics();    
     return 0;
 }
 
+bool Planner::mayContainPlan() {
+    if (!_params.isNonzero("do")) return true;
+    if (_depth_oracle.canContainPlan(*_layers.back())) return true;
+    Log::i("Skipping SAT call at layer %i: layer cannot contain a plan\n", _layer_idx);
+    return false;
+}
+
 void Planner::improvePlan(int& iteration) {
 
+    TRACE_SCOPE("optimization");
+    _phase = "optimizing";
+
     // Compute extra layers after initial solution as desired
     PlanOptimizer optimizer(_htn, _layers, _enc);
+    optimizer.setImprovedPlanCallback([this](const Plan& plan, int length) {
+        streamPlan(plan, length);
+    });
     int maxIterations = _params.getIntParam("D");
     int extraLayers = _params.getIntParam("el");
     int upperBound = _layers.back()->size()-1;
@@ -103,6 +133,7 @@ void Planner::improvePlan(int& iteration) {
         _has_plan = true;
         upperBound = optimizer.getPlanLength(std::get<0>(_plan));
         Log::i("Initial plan at most shallow layer has length %i\n", upperBound);
+        streamPlan(_plan, upperBound);
         
         if (extraLayers == -1) {
 
@@ -127,10 +158,13 @@ void Planner::improvePlan(int& iteration) {
                     upperBound = newLength;
                     _plan = thisLayerPlan;
                     _has_plan = true;
+                    streamPlan(_plan, upperBound);
                 }
                 Log::i("Initial plan at layer %i has length %i\n", iteration, newLength);
                 // Optimize
+                _phase = "optimizing";
                 optimizer.optimizePlan(upperBound, _plan, PlanOptimizer::ConstraintAddition::TRANSIENT);
+                upperBound = optimizer.getPlanLength(std::get<0>(_plan));
                 // Double number of extra layers in next iteration
                 el *= 2;
             } while (maxIterations == 0 || iteration < maxIterations);
@@ -160,19 +194,38 @@ void Planner::improvePlan(int& iteration) {
                 upperBound = newLength;
                 _plan = finalLayerPlan;
                 _has_plan = true;
+                streamPlan(_plan, upperBound);
             }
             Log::i("Initial plan at final layer has length %i\n", newLength);
             // Optimize
+            _phase = "optimizing";
             optimizer.optimizePlan(upperBound, _plan, PlanOptimizer::ConstraintAddition::PERMANENT);
 
         } else {
             // Just extract plan
             _plan = _enc.extractPlan();
             _has_plan = true;
+            streamPlan(_plan, optimizer.getPlanLength(std::get<0>(_plan)));
         }
     }
 }
 
+void Planner::outputPlan() {
+    if (_metrics.isActive()) {
+        _metrics.begin("plan")
+            .add("plan_length", (long)_best_plan_length)
+            .add("time_to_first_plan", (double)_time_at_first_plan)
+            .add("layer", (long)_layers.size()-1)
+            .end();
+    }
+    _plan_writer.outputPlan(_plan);
+}
+
+void Planner::streamPlan(const Plan& plan, int length) {
+    _best_plan_length = length;
+    _plan_writer.streamPlan(plan, length, _layers.size()-1);
+}
+
 void Planner::incrementPosition() {
     _num_instantiated_actions += _layers[_layer_idx]->at(_pos).getActions().size();
     _num_instantiated_reductions += _layers[_layer_idx]->at(_pos).getReductions().size();
@@ -228,6 +281,7 @@ void Planner::createFirstLayer() {
     _enc.encode(_layer_idx, _pos++);
     _enc.encode(_layer_idx, _pos++);
     initLayer.consolidate();
+    writeMetrics("layer");
 }
 
 void Planner::createNextLayer() {
@@ -241,9 +295,11 @@ void Planner::createNextLayer() {
 
     // Instantiate new layer
     Log::i("Instantiating ...\n");
+    _phase = "instantiating";
+    TRACE_INSTANT("layer");
     for (_old_pos = 0; _old_pos < oldLayer.size(); _old_pos++) {
         size_t newPos = oldLayer.getSuccessorPos(_old_pos);
-        size_t maxOffset = oldLayer[_old_pos].getMaxExpansionSize();
+        size_t maxOffset = oldLayer.getExpansionSize(_old_pos);
 
         // Instantiate each new position induced by the old position
         for (size_t offset = 0; offset < maxOffset; offset++) {
@@ -264,6 +320,7 @@ void Planner::createNextLayer() {
 
             incrementPosition();
             checkTermination();
+            _memory_budget.check(_layer_idx);
         }
     }
     if (_pos > 0) _layers[_layer_idx]->at(_pos-1).clearAfterInstantiation();
@@ -272,22 +329,29 @@ void Planner::createNextLayer() {
 
     // Encode new layer
     Log::i("Encoding ...\n");
+    _phase = "encoding";
     for (_old_pos = 0; _old_pos < oldLayer.size(); _old_pos++) {
         size_t newPos = oldLayer.getSuccessorPos(_old_pos);
-        size_t maxOffset = oldLayer[_old_pos].getMaxExpansionSize();
+        size_t maxOffset = oldLayer.getExpansionSize(_old_pos);
         for (size_t offset = 0; offset < maxOffset; offset++) {
             _pos = newPos + offset;
             Log::v("- Position (%i,%i)\n", _layer_idx, _pos);
             _enc.encode(_layer_idx, _pos);
             clearDonePositions(offset);
+            _memory_budget.check(_layer_idx);
         }
     }
 
     newLayer.consolidate();
+    writeMetrics("layer");
 }
 
 void Planner::createNextPosition() {
 
+    TRACE_SCOPE("instantiation");
+    auto& stats = _enc.getEncodingStatistics();
+    stats.beginInstantiation(_layer_idx, _pos);
+
     // Set up all facts that may hold at this position.
     if (_pos == 0) {
         propagateInitialState();
@@ -309,6 +373,8 @@ void Planner::createNextPosition() {
     // add all effects of the actions and reductions occurring HERE
     // as (initially false) facts to THIS position.  
     initializeNextEffects();
+
+    stats.endInstantiation();
 }
 
 void Planner::createNextPositionFromAbove() {
@@ -669,12 +735,21 @@ void Planner::propagateReductions(size_t offset) {
     NodeHashMap<USignature, USigSet, USignatureHasher> subtaskToParents;
     NodeHashSet<USignature, USignatureHasher> reductionsWithChildren;
 
+    bool deferred = _layers[_layer_idx-1]->isExpansionDeferred(_old_pos);
+
     // Collect all possible subtasks and remember their possible parents
     for (const auto& rSig : above.getReductions()) {
 
         const Reduction r = _htn.getOpTable().getReduction(rSig);
         
-        if (offset < r.getSubtasks().size()) {
+        if (deferred && !r.getSubtasks().empty()) {
+            // Repeat the reduction as is: it will be expanded at a later layer
+            assert(offset == 0);
+            reductionsWithChildren.insert(rSig);
+            newPos.addReduction(rSig);
+            newPos.addExpansionSize(r.getSubtasks().size());
+            newPos.addExpansion(rSig, rSig);
+        } else if (offset < r.getSubtasks().size()) {
             // Proper expansion
             const USignature& subtask = r.getSubtasks()[offset];
             subtaskToParents[subtask].insert(rSig);
@@ -900,23 +975,25 @@ void Planner::clearDonePositions(int offset) {
     }
     if (positionToClearAbove != nullptr) {
         Log::v("  Freeing most memory of (%i,%i) ...\n", positionToClearAbove->getLayerIndex(), positionToClearAbove->getPositionIndex());
+        _enc.meltOperationVariables(*positionToClearAbove);
         positionToClearAbove->clearAtPastLayer();
     }
 }
 
 void Planner::checkTermination() {
+    reportStatus();
     bool exitSet = SignalManager::isExitSet();
     bool cancelOpt = cancelOptimization();
     if (exitSet) {
         if (_has_plan) {
             Log::i("Termination signal caught - printing last found plan.\n");
-            _plan_writer.outputPlan(_plan);
+            outputPlan();
         } else {
             Log::i("Termination signal caught.\n");
         }
     } else if (cancelOpt) {
         Log::i("Cancelling optimization according to provided limit.\n");
-        _plan_writer.outputPlan(_plan);
+        outputPlan();
     } else if (_time_at_first_plan == 0 
             && _init_plan_time_limit > 0
             && Timer::elapsedSeconds() > _init_plan_time_limit) {
@@ -937,11 +1014,17 @@ bool Planner::cancelOptimization() {
 }
 
 int Planner::getTerminateSatCall() {
+    reportStatus();
     // Breaking out of first SAT call after some time
     if (_sat_time_limit > 0 &&
         _enc.getTimeSinceSatCallStart() > _sat_time_limit) {
         return 1;
     }
+    // Breaking out of a SAT call which only finds phase hints
+    if (_hint_time_limit > 0 &&
+        _enc.getTimeSinceSatCallStart() > _hint_time_limit) {
+        return 1;
+    }
     // Termination due to initial planning time limit (-T)
     if (_time_at_first_plan == 0 &&
         _init_plan_time_limit > 0 &&
@@ -962,8 +1045,80 @@ void Planner::printStatistics() {
     Log::i("# instantiated positions: %i\n", _num_instantiated_positions);
     Log::i("# instantiated actions: %i\n", _num_instantiated_actions);
     Log::i("# instantiated reductions: %i\n", _num_instantiated_reductions);
+    Log::i("# instantiation cache hits: %i\n", _instantiator.getNumCacheHits());
+    Log::i("# instantiation cache misses: %i\n", _instantiator.getNumCacheMisses());
+    Log::i("# parallel instantiations: %i\n", _instantiator.getNumParallelInstantiations());
     Log::i("# introduced pseudo-constants: %i\n", _htn.getNumberOfQConstants());
     Log::i("# retroactive prunings: %i\n", _pruning.getNumRetroactivePunings());
     Log::i("# retroactively pruned operations: %i\n", _pruning.getNumRetroactivelyPrunedOps());
     Log::i("# dominated operations: %i\n", _domination_resolver.getNumDominatedOps());
+    Log::i("# domination checks: %i\n", _domination_resolver.getNumDominationChecks());
+    Log::i("# domination checks skipped by bucketing: %i (est. %.4fs saved)\n", 
+            _domination_resolver.getNumSkippedDominationChecks(), _domination_resolver.getEstimatedTimeSaved());
+    if (_memory_budget.isActive()) {
+        Log::i("# memory budget interventions: %i (peak RSS %.1f MB)\n", 
+                _memory_budget.getNumInterventions(), _memory_budget.getPeakRssKb() / 1024);
+        Log::i("# memory budget dropped cache entries: %i\n", _memory_budget.getNumDroppedCacheEntries());
+        Log::i("# memory budget spilled positions: %i (%.1f MB)\n", 
+                _memory_budget.getNumSpilledPositions(), _memory_budget.getNumSpilledBytes() / 1024.0 / 1024.0);
+    }
+}
+
+void Planner::writeMetrics(const char* event, int result, float satTime) {
+    if (!_metrics.isActive()) return;
+
+    double vm, rss;
+    process_mem_usage(vm, rss);
+    auto& stats = _enc.getEncodingStatistics();
+    
+    _metrics.begin(event)
+        .add("layer", (long)_layers.size()-1)
+        .add("layer_size", _layers.empty() ? 0 : _layers.back()->size())
+        .add("positions", _num_instantiated_positions)
+        .add("actions", _num_instantiated_actions)
+        .add("reductions", _num_instantiated_reductions)
+        .add("q_constants", _htn.getNumberOfQConstants())
+        .add("clauses", stats._num_cls)
+        .add("literals", stats._num_lits)
+        .add("variables", VariableDomain::getMaxVar());
+    if (result >= 0) {
+        _metrics.add("result", result == 10 ? "sat" : (result == 20 ? "unsat" : "interrupted"))
+            .add("sat_time", (double)satTime);
+    }
+    _metrics.add("rss_kb", rss)
+        .add("dominated_ops", _domination_resolver.getNumDominatedOps())
+        .add("retroactive_prunings", _pruning.getNumRetroactivePunings())
+        .add("pruned_ops", _pruning.getNumRetroactivelyPrunedOps())
+        .end();
+}
+
+void Planner::reportStatus() {
+    bool requested = SignalManager::consumeStatusRequest();
+    float time = Timer::elapsedSeconds();
+    bool periodic = !_status_file.empty() && time - _last_status_time >= _status_interval;
+    if (!requested && !periodic) return;
+    _last_status_time = time;
+
+    float satTime = _enc.getTimeSinceSatCallStart();
+    const char* phase = satTime > 0 ? (_time_at_first_plan > 0 ? "optimizing" : "solving") : _phase;
+    double vm, rss;
+    process_mem_usage(vm, rss);
+
+    char status[512];
+    snprintf(status, sizeof(status), 
+            "time: %.3f\nphase: %s\niteration: %lu\nlayer: %lu\nposition: %lu\nlayer_size: %lu\n"
+            "sat_time: %.3f\nbest_plan_length: %i\nrss_kb: %.0f\n",
+            time, phase, _layers.empty() ? 0 : _layers.size()-1, _layer_idx, _pos, _layers.empty() ? 0 : _layers.back()->size(), 
+            satTime, _best_plan_length, rss);
+
+    if (requested) Log::i("Status:\n%s", status);
+    if (_status_file.empty()) return;
+
+    // Write to temporary file and move it into place so that readers never see a partial status
+    std::string tmpFile = _status_file + ".tmp";
+    FILE* f = fopen(tmpFile.c_str(), "w");
+    if (f == nullptr) return;
+    fputs(status, f);
+    fclose(f);
+    rename(tmpFile.c_str(), _status_file.c_str());
 }
@@ -11,11 +11,14 @@
 #include "algo/arg_iterator.h"
 #include "algo/precondition_inference.h"
 #include "algo/minres.h"
+#include "algo/depth_oracle.h"
 #include "algo/fact_analysis.h"
 #include "algo/retroactive_pruning.h"
 #include "algo/domination_resolver.h"
 #include "algo/plan_writer.h"
+#include "algo/memory_budget.h"
 #include "sat/encoding.h"
+#include "util/metrics_sink.h"
 
 typedef std::pair<std::vector<PlanItem>, std::vector<PlanItem>> Plan;
 
@@ -32,9 +35,12 @@ private:
     Instantiator _instantiator;
     Encoding _enc;
     MinRES _minres;
+    DepthOracle _depth_oracle;
     RetroactivePruning _pruning;
     DominationResolver _domination_resolver;
     PlanWriter _plan_writer;
+    MetricsSink _metrics;
+    MemoryBudget _memory_budget;
 
     std::vector<Layer*> _layers;
 
@@ -43,6 +49,7 @@ private:
     size_t _old_pos;
 
     float _sat_time_limit = 0;
+    float _hint_time_limit = 0;
     float _init_plan_time_limit = 0;
     bool _nonprimitive_support;
     float _optimization_factor;
@@ -50,6 +57,15 @@ private:
 
     bool _has_plan;
     Plan _plan;
+    // Length of the last streamed plan (-1: none yet); 
+    // cheap to read from the SAT solver's terminate callback
+    int _best_plan_length = -1;
+
+    // Live status reporting
+    const char* _phase = "instantiating";
+    std::string _status_file;
+    float _status_interval;
+    float _last_status_time = 0;
 
     // statistics
     size_t _num_instantiated_positions = 0;
@@ -62,16 +78,28 @@ public:
             _instantiator(params, htn, _analysis), 
             _enc(_params, _htn, _analysis, _layers, [this](){checkTermination();}), 
             _minres(_htn), 
+            _depth_oracle(_htn, _minres),
             _pruning(_layers, _enc),
             _domination_resolver(_htn),
             _plan_writer(_htn, _params),
+            _metrics(_params.getParam("mf", "")),
+            _memory_budget(params, _layers, _analysis, _instantiator, _domination_resolver),
             _init_plan_time_limit(_params.getFloatParam("T")), _nonprimitive_support(_params.isNonzero("nps")), 
-            _optimization_factor(_params.getFloatParam("of")), _has_plan(false) {
+            _optimization_factor(_params.getFloatParam("of")), _has_plan(false),
+            _status_file(_params.getParam("sf", "")), _status_interval(_params.getFloatParam("sfi")) {
 
         // Mine additional preconditions for reductions from their subtasks
         PreconditionInference::infer(_htn, _analysis, PreconditionInference::MinePrecMode(_params.getIntParam("mp")));
+
+        if (_metrics.isActive()) _enc.setSolveCallback([this](int result, float time) {
+            writeMetrics("sat", result, time);
+        });
     }
     int findPlan();
+    // The best plan found by findPlan()
+    const Plan& getPlan() const {return _plan;}
+    Encoding& getEncoding() {return _enc;}
+    size_t getNumLayers() const {return _layers.size();}
     void improvePlan(int& iteration);
 
     friend int terminateSatCall(void* state);
@@ -88,6 +116,10 @@ private:
     void createNextPositionFromLeft(Position& left);
 
     void incrementPosition();
+    // Writes the "plan" metrics record and outputs the final plan
+    void outputPlan();
+    // Remembers the length of an improved plan and streams the plan
+    void streamPlan(const Plan& plan, int length);
 
     void addPreconditionConstraints();
     void addPreconditionsAndConstraints(const USignature& op, const SigSet& preconditions, bool isActionRepetition);
@@ -107,9 +139,12 @@ private:
     void initializeFact(Position& newPos, const USignature& fact);
     void addQConstantTypeConstraints(const USignature& op);
 
+    bool mayContainPlan();
     int getTerminateSatCall();
     void clearDonePositions(int offset);
     void printStatistics();
+    void writeMetrics(const char* event, int result = -1, float satTime = 0);
+    void reportStatus();
 
 };
 
@@ -14,7 +14,7 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
     while (!openOps.empty()) {
         PositionedUSig psig = *openOps.begin();
         openOps.erase(psig);
-        Log::d("PRUNE_UP %s\n", TOSTR(psig));
+        LOG_D("PRUNE_UP %s\n", TOSTR(psig));
 
         if (psig.layer == 0) {
             // Top of the hierarchy hit
@@ -30,22 +30,21 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
             oldPos++;
 
         bool pruneSomeParent = false;
-        assert(position.getPredecessors().count(psig.usig) || Log::e("%s has no predecessors!\n", TOSTR(psig)));
-        for (const auto& parent : position.getPredecessors().at(psig.usig)) {
+        assert(position.hasPredecessors(psig.usig) || Log::e("%s has no predecessors!\n", TOSTR(psig)));
+        position.forEachPredecessor(psig.usig, [&](const USignature& parent) {
             PositionedUSig parentPSig(psig.layer-1, oldPos, parent);
             //assert(oldLayer.at(oldPos).hasAction(parent) || oldLayer.at(oldPos).hasReduction(parent) || Log::e("%s\n", TOSTR(parentPSig)));
-            const auto& siblings = position.getExpansions().at(parent);
 
             // Mark op for removal from expansion of the parent
-            assert(siblings.count(psig.usig));
+            assert(position.hasExpansion(parent, psig.usig));
             removedExpansionsOfParents[parentPSig].insert(psig.usig);
 
-            if (removedExpansionsOfParents[parentPSig].size() == siblings.size()) {
+            if (removedExpansionsOfParents[parentPSig].size() == position.getNumExpansions(parent)) {
                 // Siblings become empty -> prune parent as well
                 openOps.insert(std::move(parentPSig));
                 pruneSomeParent = true;
             }
-        }
+        });
 
         // No parent pruned? -> This op is a root of a subtree to be pruned
         if (!pruneSomeParent) opsToRemove.insert(psig);
@@ -57,7 +56,7 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
         PositionedUSig psig = *opsToRemove.begin();
         opsToRemove.erase(psig);
         Position& position = _layers[psig.layer]->at(psig.pos);
-        Log::d("PRUNE_DOWN %s\n", TOSTR(psig));
+        LOG_D("PRUNE_DOWN %s\n", TOSTR(psig));
         assert(position.hasAction(psig.usig) || position.hasReduction(psig.usig));
 
         // Go down one layer and mark all children for removal which have only one predecessor left
@@ -66,19 +65,21 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
             while (belowPosIdx < (int)_layers.at(psig.layer)->getSuccessorPos(psig.pos+1)) {
 
                 Position& below = _layers.at(psig.layer+1)->at(belowPosIdx);
-                if (below.getExpansions().count(psig.usig)) for (auto& child : below.getExpansions().at(psig.usig)) {
-                    assert(below.getPredecessors().at(child).count(psig.usig));
-                    if (psig.layer+1 == (size_t)layerIdx && belowPosIdx == pos && child == op) {
-                        // Arrived back at original op to prune
-                        opsToRemove.emplace(layerIdx, pos, op);
-                    } else if (below.getPredecessors().at(child).size() == 1) {
-                        // Child has this op as its only predecessor -> prune
-                        opsToRemove.emplace(psig.layer+1, belowPosIdx, child);
-                    } else {
-                        Log::d("PRUNE %i pred left for %s@(%i,%i): %s\n", below.getPredecessors().at(child).size()-1, TOSTR(child), psig.layer+1, belowPosIdx);
-                        below.getPredecessors().at(child).erase(psig.usig);
-                    }
-                } else Log::d("PRUNE No expansions for %s @ (%i,%i)\n", TOSTR(psig), psig.layer+1, belowPosIdx);
+                if (below.hasExpansions(psig.usig)) {
+                    below.forEachExpansion(psig.usig, [&](const USignature& child) {
+                        assert(below.hasPredecessor(child, psig.usig));
+                        if (psig.layer+1 == (size_t)layerIdx && belowPosIdx == pos && child == op) {
+                            // Arrived back at original op to prune
+                            opsToRemove.emplace(layerIdx, pos, op);
+                        } else if (below.getNumPredecessors(child) == 1) {
+                            // Child has this op as its only predecessor -> prune
+                            opsToRemove.emplace(psig.layer+1, belowPosIdx, child);
+                        } else {
+                            LOG_D("PRUNE %i pred left for %s@(%i,%i): %s\n", below.getNumPredecessors(child)-1, TOSTR(child), psig.layer+1, belowPosIdx);
+                            below.removePredecessor(child, psig.usig);
+                        }
+                    });
+                } else LOG_D("PRUNE No expansions for %s @ (%i,%i)\n", TOSTR(psig), psig.layer+1, belowPosIdx);
 
                 belowPosIdx++;
             }
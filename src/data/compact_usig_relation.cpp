@@ -0,0 +1,172 @@
+
+#include <algorithm>
+
+#include "data/compact_usig_relation.h"
+
+CompactUSigTable::CompactUSigTable(const std::vector<const USignature*>& sortedSigs) {
+    size_t numArgs = 0;
+    for (const USignature* sig : sortedSigs) numArgs += sig->_args.size();
+    _name_ids.reserve(sortedSigs.size());
+    _arg_offsets.reserve(sortedSigs.size()+1);
+    _args.reserve(numArgs);
+    _arg_offsets.push_back(0);
+    for (const USignature* sig : sortedSigs) {
+        _name_ids.push_back(sig->_name_id);
+        _args.insert(_args.end(), sig->_args.begin(), sig->_args.end());
+        _arg_offsets.push_back(_args.size());
+    }
+}
+
+int CompactUSigTable::compare(const USignature& a, const USignature& b) {
+    if (a._name_id != b._name_id) return a._name_id < b._name_id ? -1 : 1;
+    if (a._args.size() != b._args.size()) return a._args.size() < b._args.size() ? -1 : 1;
+    for (size_t i = 0; i < a._args.size(); i++) {
+        if (a._args[i] != b._args[i]) return a._args[i] < b._args[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int CompactUSigTable::compareAt(size_t idx, const USignature& sig) const {
+    if (_name_ids[idx] != sig._name_id) return _name_ids[idx] < sig._name_id ? -1 : 1;
+    size_t begin = _arg_offsets[idx];
+    size_t arity = _arg_offsets[idx+1] - begin;
+    if (arity != sig._args.size()) return arity < sig._args.size() ? -1 : 1;
+    for (size_t i = 0; i < arity; i++) {
+        if (_args[begin+i] != sig._args[i]) return _args[begin+i] < sig._args[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int CompactUSigTable::find(const USignature& sig) const {
+    size_t lo = 0, hi = size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = compareAt(mid, sig);
+        if (cmp == 0) return mid;
+        if (cmp < 0) lo = mid+1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+USignature CompactUSigTable::get(size_t idx) const {
+    return USignature(_name_ids[idx], std::vector<int>(_args.begin()+_arg_offsets[idx], _args.begin()+_arg_offsets[idx+1]));
+}
+
+size_t CompactUSigTable::getMemoryBytes() const {
+    return _name_ids.capacity() * sizeof(int) + _arg_offsets.capacity() * sizeof(uint32_t) + _args.capacity() * sizeof(int);
+}
+
+
+
+CompactUSigRelation::CompactUSigRelation(const USigSetMap& forward, const USigSetMap& inverse) {
+
+    // Collect, sort and deduplicate all keys and values
+    std::vector<const USignature*> keys, values;
+    for (const auto& [key, vals] : forward) {
+        keys.push_back(&key);
+        for (const auto& val : vals) values.push_back(&val);
+    }
+    for (const auto& [val, ks] : inverse) {
+        values.push_back(&val);
+        for (const auto& key : ks) keys.push_back(&key);
+    }
+    auto less = [](const USignature* a, const USignature* b) {return CompactUSigTable::compare(*a, *b) < 0;};
+    auto equal = [](const USignature* a, const USignature* b) {return *a == *b;};
+    for (auto* sigs : {&keys, &values}) {
+        std::sort(sigs->begin(), sigs->end(), less);
+        sigs->erase(std::unique(sigs->begin(), sigs->end(), equal), sigs->end());
+    }
+    _keys = CompactUSigTable(keys);
+    _values = CompactUSigTable(values);
+
+    buildAdjacency(forward, _keys, _values, _offsets, _targets);
+    buildAdjacency(inverse, _values, _keys, _inv_offsets, _inv_targets);
+    _removed_values.resize(_values.size());
+    _removed_inv_entries.resize(_inv_targets.size());
+}
+
+void CompactUSigRelation::buildAdjacency(const USigSetMap& map, const CompactUSigTable& from, const CompactUSigTable& to,
+            std::vector<uint32_t>& offsets, std::vector<uint32_t>& targets) {
+
+    std::vector<uint32_t> sizes(from.size(), 0);
+    for (const auto& [sig, set] : map) sizes[from.find(sig)] = set.size();
+
+    offsets.resize(from.size()+1);
+    offsets[0] = 0;
+    for (size_t i = 0; i < from.size(); i++) offsets[i+1] = offsets[i] + sizes[i];
+
+    targets.resize(offsets.back());
+    for (const auto& [sig, set] : map) {
+        size_t begin = offsets[from.find(sig)];
+        size_t i = begin;
+        for (const auto& target : set) targets[i++] = to.find(target);
+        // Sorted targets allow for binary search
+        std::sort(targets.begin()+begin, targets.begin()+i);
+    }
+}
+
+int CompactUSigRelation::findTarget(const std::vector<uint32_t>& targets, size_t begin, size_t end, uint32_t target) {
+    auto it = std::lower_bound(targets.begin()+begin, targets.begin()+end, target);
+    if (it == targets.begin()+end || *it != target) return -1;
+    return it - targets.begin();
+}
+
+size_t CompactUSigRelation::getNumValues(const USignature& key) const {
+    int k = _keys.find(key);
+    if (k < 0) return 0;
+    size_t num = 0;
+    for (size_t i = _offsets[k]; i < _offsets[k+1]; i++) {
+        if (!_removed_values[_targets[i]]) num++;
+    }
+    return num;
+}
+
+bool CompactUSigRelation::contains(const USignature& key, const USignature& value) const {
+    int k = _keys.find(key);
+    int v = _values.find(value);
+    if (k < 0 || v < 0 || _removed_values[v]) return false;
+    return findTarget(_targets, _offsets[k], _offsets[k+1], v) >= 0;
+}
+
+bool CompactUSigRelation::hasInverse(const USignature& value) const {
+    int v = _values.find(value);
+    return v >= 0 && !_removed_values[v];
+}
+
+size_t CompactUSigRelation::getNumInverse(const USignature& value) const {
+    int v = _values.find(value);
+    if (v < 0 || _removed_values[v]) return 0;
+    size_t num = 0;
+    for (size_t i = _inv_offsets[v]; i < _inv_offsets[v+1]; i++) {
+        if (!_removed_inv_entries[i]) num++;
+    }
+    return num;
+}
+
+bool CompactUSigRelation::containsInverse(const USignature& value, const USignature& key) const {
+    int v = _values.find(value);
+    int k = _keys.find(key);
+    if (v < 0 || k < 0 || _removed_values[v]) return false;
+    int i = findTarget(_inv_targets, _inv_offsets[v], _inv_offsets[v+1], k);
+    return i >= 0 && !_removed_inv_entries[i];
+}
+
+void CompactUSigRelation::removeValue(const USignature& value) {
+    int v = _values.find(value);
+    if (v >= 0) _removed_values[v] = true;
+}
+
+void CompactUSigRelation::removeInverse(const USignature& value, const USignature& key) {
+    int v = _values.find(value);
+    int k = _keys.find(key);
+    if (v < 0 || k < 0) return;
+    int i = findTarget(_inv_targets, _inv_offsets[v], _inv_offsets[v+1], k);
+    if (i >= 0) _removed_inv_entries[i] = true;
+}
+
+size_t CompactUSigRelation::getMemoryBytes() const {
+    return _keys.getMemoryBytes() + _values.getMemoryBytes()
+        + (_offsets.capacity() + _targets.capacity() + _inv_offsets.capacity() + _inv_targets.capacity()) * sizeof(uint32_t)
+        + (_removed_values.capacity() + _removed_inv_entries.capacity()) / 8;
+}
@@ -0,0 +1,112 @@
+
+#ifndef DOMPASCH_LILOTANE_COMPACT_USIG_RELATION_H
+#define DOMPASCH_LILOTANE_COMPACT_USIG_RELATION_H
+
+#include <vector>
+#include <cstdint>
+
+#include "data/signature.h"
+#include "util/hashmap.h"
+
+/*
+Read-only, sorted and deduplicated set of signatures in a flat layout
+(one name id and one offset per signature, all arguments in a single array).
+Signatures are addressed by their index in the sorted order.
+*/
+class CompactUSigTable {
+
+private:
+    std::vector<int> _name_ids;
+    std::vector<uint32_t> _arg_offsets;
+    std::vector<int> _args;
+
+public:
+    CompactUSigTable() = default;
+    // The given signatures must be sorted w.r.t. compare() and free of duplicates
+    CompactUSigTable(const std::vector<const USignature*>& sortedSigs);
+
+    size_t size() const {return _name_ids.size();}
+    // Returns the index of the signature or -1 if it is not contained
+    int find(const USignature& sig) const;
+    USignature get(size_t idx) const;
+    size_t getMemoryBytes() const;
+
+    // Total order on signatures: by name, then by arity, then lexicographically by arguments
+    static int compare(const USignature& a, const USignature& b);
+
+private:
+    int compareAt(size_t idx, const USignature& sig) const;
+};
+
+/*
+Read-only binary relation between two sets of signatures ("keys" and "values"),
+e.g., the expansions of parent operations into child operations.
+Forward (key -> values) and inverse (value -> keys) adjacencies are stored
+in compressed sparse row layout and may be given independently of each other.
+Values can be removed altogether, and single inverse entries can be removed;
+removals only set tombstones and never reallocate.
+*/
+class CompactUSigRelation {
+
+public:
+    typedef NodeHashMap<USignature, USigSet, USignatureHasher> USigSetMap;
+
+private:
+    CompactUSigTable _keys;
+    CompactUSigTable _values;
+
+    // key -> values
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _targets;
+    // value -> keys
+    std::vector<uint32_t> _inv_offsets;
+    std::vector<uint32_t> _inv_targets;
+
+    std::vector<bool> _removed_values;
+    std::vector<bool> _removed_inv_entries;
+
+public:
+    CompactUSigRelation() = default;
+    // Builds the relation from a forward map (key -> values) and, optionally, an inverse map (value -> keys)
+    CompactUSigRelation(const USigSetMap& forward, const USigSetMap& inverse = USigSetMap());
+
+    bool hasKey(const USignature& key) const {return _keys.find(key) >= 0;}
+    // Number of (non-removed) values of the key
+    size_t getNumValues(const USignature& key) const;
+    bool contains(const USignature& key, const USignature& value) const;
+    template <typename F>
+    void forEachValue(const USignature& key, F f) const {
+        int k = _keys.find(key);
+        if (k < 0) return;
+        for (size_t i = _offsets[k]; i < _offsets[k+1]; i++) {
+            if (!_removed_values[_targets[i]]) f(_values.get(_targets[i]));
+        }
+    }
+
+    // Whether the value is known and has not been removed
+    bool hasInverse(const USignature& value) const;
+    size_t getNumInverse(const USignature& value) const;
+    bool containsInverse(const USignature& value, const USignature& key) const;
+    template <typename F>
+    void forEachInverse(const USignature& value, F f) const {
+        int v = _values.find(value);
+        if (v < 0 || _removed_values[v]) return;
+        for (size_t i = _inv_offsets[v]; i < _inv_offsets[v+1]; i++) {
+            if (!_removed_inv_entries[i]) f(_keys.get(_inv_targets[i]));
+        }
+    }
+
+    // Removes the value from all keys' values and drops its inverse entries
+    void removeValue(const USignature& value);
+    // Removes a single key from the inverse entries of the value
+    void removeInverse(const USignature& value, const USignature& key);
+
+    size_t getMemoryBytes() const;
+
+private:
+    static void buildAdjacency(const USigSetMap& map, const CompactUSigTable& from, const CompactUSigTable& to,
+            std::vector<uint32_t>& offsets, std::vector<uint32_t>& targets);
+    static int findTarget(const std::vector<uint32_t>& targets, size_t begin, size_t end, uint32_t target);
+};
+
+#endif
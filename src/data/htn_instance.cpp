@@ -294,7 +294,7 @@ USigSet HtnInstance::getInitState() {
                 if (c1 != c2) continue;
                 std::vector<int> args;
                 args.push_back(c1); args.push_back(c2);
-                Log::d("EQUALITY %s\n", TOSTR(args));
+                LOG_D("EQUALITY %s\n", TOSTR(args));
                 result.emplace(eqPredId, std::move(args));
             }
         }
@@ -505,14 +505,16 @@ Reduction& HtnInstance::createReduction(method& method) {
         _methods[id].orderSubtasks(orderingNodelist);
     }
 
-    Log::d(" %s : %i preconditions, %i subtasks\n", TOSTR(_methods[id].getSignature()), 
+    LOG_D(" %s : %i preconditions, %i subtasks\n", TOSTR(_methods[id].getSignature()), 
                 _methods[id].getPreconditions().size(), 
                 _methods[id].getSubtasks().size());
-    Log::d("  PRE ");
-    for (const Signature& sig : r.getPreconditions()) {
-        Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(sig));
+    if (Log::isEnabled(Log::V4_DEBUG)) {
+        Log::d("  PRE ");
+        for (const Signature& sig : r.getPreconditions()) {
+            Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(sig));
+        }
+        Log::log_notime(Log::V4_DEBUG, "\n");
     }
-    Log::log_notime(Log::V4_DEBUG, "\n");
 
     return _methods[id];
 }
@@ -705,7 +707,7 @@ std::vector<int> HtnInstance::replaceVariablesWithQConstants(const HtnOp& op,
         auto& domain = domainPerVariable[i];
         if (domain.empty()) {
             // No valid constants at this position! The op is impossible.
-            Log::d("Empty domain for arg %s of %s\n", TOSTR(vararg), TOSTR(op.getSignature()));
+            LOG_D("Empty domain for arg %s of %s\n", TOSTR(vararg), TOSTR(op.getSignature()));
             return vecFailure;
         }
         if (domain.size() == 1) {
@@ -740,13 +742,15 @@ std::vector<int> HtnInstance::replaceVariablesWithQConstants(const HtnOp& op,
             domainsPerQConst[args[i]] = std::move(domainVec);
             assert(domain == getDomainOfQConstant(args[i]));
             assert(getOriginOfQConstant(args[i]) == IntPair(layerIdx, pos));
-            /*
-            Log::d("QC %s : %s ~> %s ( ", TOSTR(op.getSignature()), TOSTR(vararg), TOSTR(args[i]), domain.size());
-            for (int c : domain) {
-                Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(c));
+            LOG_D("QC %s : %s ~> %s (%i constants)\n", TOSTR(op.getSignature()), TOSTR(vararg), 
+                    TOSTR(args[i]), domain.size());
+            if (Log::isEnabled(Log::V4_DEBUG)) {
+                Log::d("  DOMAIN ");
+                for (int c : domain) {
+                    Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(c));
+                }
+                Log::log_notime(Log::V4_DEBUG, "\n");
             }
-            Log::log_notime(Log::V4_DEBUG, ")\n");
-            */
         }
     }
 
@@ -806,7 +810,7 @@ std::vector<std::vector<int>> HtnInstance::getEligibleArgs(const USignature& qSi
         int arg = qSig._args[argPos];
         if (isVariable(arg) || isQConstant(arg)) {
             // Q-constant sort or variable
-            const auto& domain = _constants_by_sort.at(isQConstant(arg) ? _primary_sort_of_q_constants[arg] 
+            const auto& domain = _constants_by_sort.at(isQConstant(arg) ? _primary_sort_of_q_constants.at(arg) 
                         : getSorts(qSig._name_id).at(argPos));
             if (restrictiveSorts.empty()) {
                 eligibleArgs[argPos].insert(eligibleArgs[argPos].end(), domain.begin(), domain.end());
@@ -914,6 +918,10 @@ const std::pair<int, int>& HtnInstance::getReductionAndActionFromPrimitivization
     return _primitivization_to_parent_and_child[primitivizationName];
 }
 
+bool HtnInstance::isPrimitivization(int actionName) const {
+    return _primitivization_to_parent_and_child.count(actionName);
+}
+
 USignature HtnInstance::getNormalizedLifted(const USignature& opSig, std::vector<int>& placeholderArgs) {
     int nameId = opSig._name_id;
     
@@ -150,6 +150,7 @@ public:
     
     USignature cutNonoriginalTaskArguments(const USignature& sig);
     const std::pair<int, int>& getReductionAndActionFromPrimitivization(int primitivizationName);
+    bool isPrimitivization(int actionName) const;
 
     int nameId(const std::string& name, bool createQConstant = false, int layerIdx = -1, int pos = -1);
     std::string toString(int id) const;
@@ -14,15 +14,26 @@ Position& Layer::operator[](size_t pos) {assert(pos < size()); return _content[p
 Position& Layer::at(size_t pos) {return (*this)[pos];}
 Position& Layer::last() {return (*this)[size()-1];}
 void Layer::consolidate() {
+    _successor_positions.clear();
     int succ = 0;
     for (size_t pos = 0; pos < size(); pos++) {
         _successor_positions.push_back(succ);
-        succ += _content[pos].getMaxExpansionSize();
+        succ += getExpansionSize(pos);
     }
 }
 size_t Layer::getNextLayerSize() const {
     return _successor_positions.back()+1;
 }
+size_t Layer::getExpansionSize(size_t pos) const {
+    return isExpansionDeferred(pos) ? 1 : _content[pos].getMaxExpansionSize();
+}
+void Layer::deferExpansion(size_t pos) {
+    if (_deferred_expansions.empty()) _deferred_expansions.resize(size());
+    _deferred_expansions[pos] = true;
+}
+bool Layer::isExpansionDeferred(size_t pos) const {
+    return !_deferred_expansions.empty() && _deferred_expansions[pos];
+}
 size_t Layer::getSuccessorPos(size_t oldPos) const {
     assert(oldPos < _successor_positions.size());
     return _successor_positions[oldPos];
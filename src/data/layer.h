@@ -13,6 +13,8 @@ private:
     size_t _index;
     std::vector<Position> _content;
     std::vector<size_t> _successor_positions;
+    // Positions whose operations are only carried over to the next layer
+    std::vector<bool> _deferred_expansions;
 
 public:
     Layer(size_t index, size_t size);
@@ -22,6 +24,12 @@ public:
     size_t getNextLayerSize() const;
     size_t getSuccessorPos(size_t oldPos) const;
     std::pair<size_t, size_t> getPredecessorPosAndOffset(size_t thisPos) const;
+    size_t getExpansionSize(size_t pos) const;
+
+    // The position's reductions will be repeated at a single position of the next layer
+    // instead of being expanded. Requires a subsequent consolidate().
+    void deferExpansion(size_t pos);
+    bool isExpansionDeferred(size_t pos) const;
     
     Position& at(size_t pos);
     Position& operator[](size_t pos);
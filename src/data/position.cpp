@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include "position.h"
 
 #include "sat/variable_domain.h"
@@ -62,22 +64,40 @@ void Position::addSubstitutionConstraint(const USignature& op, SubstitutionConst
 }
 
 void Position::addQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) {
+    assert(!_frozen);
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
     set[qFact].insert(decFact);
     //Log::v("QFACTDEC %s -> %s (%s)\n", TOSTR(qFact), TOSTR(decFact), negated?"false":"true");
 }
 
 void Position::removeQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) {
+    assert(!_frozen);
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
     set[qFact].erase(decFact);
 }
 
-bool Position::hasQFactDecodings(const USignature& qFact, bool negated) {
+bool Position::hasQFactDecodings(const USignature& qFact, bool negated) const {
+    if (_frozen) return _frozen_qfact_decodings[negated].hasKey(qFact);
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
     return set.count(qFact);
 }
 
+bool Position::hasQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) const {
+    if (_frozen) return _frozen_qfact_decodings[negated].contains(qFact, decFact);
+    auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
+    auto it = set.find(qFact);
+    return it != set.end() && it->second.count(decFact);
+}
+
+size_t Position::getNumQFactDecodings(const USignature& qFact, bool negated) const {
+    if (_frozen) return _frozen_qfact_decodings[negated].getNumValues(qFact);
+    auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
+    auto it = set.find(qFact);
+    return it == set.end() ? 0 : it->second.size();
+}
+
 const USigSet& Position::getQFactDecodings(const USignature& qFact, bool negated) {
+    assert(!_frozen);
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
     assert(set.count(qFact) || Log::e("No qfact decodings for %s!\n", TOSTR(qFact)));
     return set.at(qFact);
@@ -85,17 +105,18 @@ const USigSet& Position::getQFactDecodings(const USignature& qFact, bool negated
 
 void Position::addAction(const USignature& action) {
     _actions.insert(action);
-    Log::d("+ACTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(action));
+    LOG_D("+ACTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(action));
 }
 void Position::addAction(USignature&& action) {
-    Log::d("+ACTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(action));
+    LOG_D("+ACTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(action));
     _actions.insert(std::move(action));
 }
 void Position::addReduction(const USignature& reduction) {
     _reductions.insert(reduction);
-    Log::d("+REDUCTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(reduction));
+    LOG_D("+REDUCTION@(%i,%i) %s\n", _layer_idx, _pos, TOSTR(reduction));
 }
 void Position::addExpansion(const USignature& parent, const USignature& child) {
+    assert(!_frozen);
     auto& set = _expansions[parent];
     set.insert(child);
     auto& pred = _predecessors[child];
@@ -114,6 +135,10 @@ void Position::addExpansionSize(size_t size) {_max_expansion_size = std::max(_ma
 
 void Position::removeActionOccurrence(const USignature& action) {
     _actions.erase(action);
+    if (_frozen) {
+        _frozen_expansions.removeValue(action);
+        return;
+    }
     for (auto& [parent, children] : _expansions) {
         children.erase(action);
     }
@@ -121,6 +146,10 @@ void Position::removeActionOccurrence(const USignature& action) {
 }
 void Position::removeReductionOccurrence(const USignature& reduction) {
     _reductions.erase(reduction);
+    if (_frozen) {
+        _frozen_expansions.removeValue(reduction);
+        return;
+    }
     for (auto& [parent, children] : _expansions) {
         children.erase(reduction);
     }
@@ -137,6 +166,7 @@ void Position::replaceOperation(const USignature& from, const USignature& to, Su
 }
 
 const NodeHashMap<USignature, int, USignatureHasher>& Position::getVariableTable(VarType type) const {
+    assert(type == FACT || _spill_file == nullptr);
     return type == OP ? _op_variables : _fact_variables;
 }
 void Position::setVariableTable(VarType type, const NodeHashMap<USignature, int, USignatureHasher>& table) {
@@ -146,6 +176,70 @@ void Position::setVariableTable(VarType type, const NodeHashMap<USignature, int,
         _fact_variables = table;
     }
 }
+size_t Position::spillOpVariables(SpillFile& file) {
+    if (_spill_file != nullptr || _op_variables.empty()) return 0;
+
+    // Layout (in words): #entries, word offset of each entry (+ end offset),
+    // then the entries (name id, arity, args..., variable) sorted by signature
+    std::vector<const NodeHashMap<USignature, int, USignatureHasher>::value_type*> entries;
+    entries.reserve(_op_variables.size());
+    for (const auto& entry : _op_variables) entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+        return CompactUSigTable::compare(a->first, b->first) < 0;
+    });
+
+    std::vector<int> words;
+    words.push_back(entries.size());
+    size_t offset = 0;
+    for (const auto* entry : entries) {
+        words.push_back(offset);
+        offset += 3 + entry->first._args.size();
+    }
+    words.push_back(offset);
+    for (const auto* entry : entries) {
+        words.push_back(entry->first._name_id);
+        words.push_back(entry->first._args.size());
+        words.insert(words.end(), entry->first._args.begin(), entry->first._args.end());
+        words.push_back(entry->second);
+    }
+
+    long fileOffset = file.append(words);
+    if (fileOffset < 0) return 0;
+    _spill_file = &file;
+    _spill_offset = fileOffset;
+    _op_variables.clear();
+    _op_variables.reserve(0);
+    return words.size() * sizeof(int);
+}
+
+const int* Position::getSpilledVariables() const {
+    return (const int*) (_spill_file->data() + _spill_offset);
+}
+
+int Position::getSpilledVariableOrZero(const USignature& sig) const {
+    const int* words = getSpilledVariables();
+    int num = words[0];
+    const int* offsets = words+1;
+    const int* entries = offsets+num+1;
+    int lo = 0, hi = num;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const int* entry = entries+offsets[mid];
+        // Same order as CompactUSigTable::compare, without materializing the signature
+        int cmp = 0;
+        size_t arity = entry[1];
+        if (entry[0] != sig._name_id) cmp = entry[0] < sig._name_id ? -1 : 1;
+        else if (arity != sig._args.size()) cmp = arity < sig._args.size() ? -1 : 1;
+        else for (size_t i = 0; cmp == 0 && i < arity; i++) {
+            if (entry[2+i] != sig._args[i]) cmp = entry[2+i] < sig._args[i] ? -1 : 1;
+        }
+        if (cmp == 0) return entry[2+arity];
+        if (cmp < 0) lo = mid+1;
+        else hi = mid;
+    }
+    return 0;
+}
+
 void Position::moveVariableTable(VarType type, Position& destination) {
     auto& src = type == OP ? _op_variables : _fact_variables;
     auto& dest = type == OP ? destination._op_variables : destination._fact_variables;
@@ -186,8 +280,50 @@ const NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher>& Po
 
 USigSet& Position::getActions() {return _actions;}
 const USigSet& Position::getReductions() const {return _reductions;}
-NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getExpansions() {return _expansions;}
-NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getPredecessors() {return _predecessors;}
+NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getExpansions() {
+    assert(!_frozen);
+    return _expansions;
+}
+NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getPredecessors() {
+    assert(!_frozen);
+    return _predecessors;
+}
+
+bool Position::hasExpansions(const USignature& parent) const {
+    if (_frozen) return _frozen_expansions.hasKey(parent);
+    return _expansions.count(parent);
+}
+bool Position::hasExpansion(const USignature& parent, const USignature& child) const {
+    if (_frozen) return _frozen_expansions.contains(parent, child);
+    auto it = _expansions.find(parent);
+    return it != _expansions.end() && it->second.count(child);
+}
+size_t Position::getNumExpansions(const USignature& parent) const {
+    if (_frozen) return _frozen_expansions.getNumValues(parent);
+    auto it = _expansions.find(parent);
+    return it == _expansions.end() ? 0 : it->second.size();
+}
+bool Position::hasPredecessors(const USignature& child) const {
+    if (_frozen) return _frozen_expansions.hasInverse(child);
+    return _predecessors.count(child);
+}
+bool Position::hasPredecessor(const USignature& child, const USignature& parent) const {
+    if (_frozen) return _frozen_expansions.containsInverse(child, parent);
+    auto it = _predecessors.find(child);
+    return it != _predecessors.end() && it->second.count(parent);
+}
+size_t Position::getNumPredecessors(const USignature& child) const {
+    if (_frozen) return _frozen_expansions.getNumInverse(child);
+    auto it = _predecessors.find(child);
+    return it == _predecessors.end() ? 0 : it->second.size();
+}
+void Position::removePredecessor(const USignature& child, const USignature& parent) {
+    if (_frozen) _frozen_expansions.removeInverse(child, parent);
+    else {
+        auto it = _predecessors.find(child);
+        if (it != _predecessors.end()) it->second.erase(parent);
+    }
+}
 const NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>& Position::getExpansionSubstitutions() const {return _expansion_substitutions;}
 const USigSet& Position::getAxiomaticOps() const {return _axiomatic_ops;}
 size_t Position::getMaxExpansionSize() const {return _max_expansion_size;}
@@ -195,29 +331,49 @@ size_t Position::getMaxExpansionSize() const {return _max_expansion_size;}
 void Position::clearAfterInstantiation() {
 }
 
-void Position::clearAtPastPosition() {
-    _qfacts.clear();
-    _qfacts.reserve(0);
-    /*
+void Position::freeze() {
+    if (_frozen) return;
+
+    _frozen_expansions = CompactUSigRelation(_expansions, _predecessors);
     _expansions.clear();
     _expansions.reserve(0);
     _predecessors.clear();
     _predecessors.reserve(0);
-    */
-   _expansion_substitutions.clear();
-   _expansion_substitutions.reserve(0);
+
+    _frozen_qfact_decodings[0] = CompactUSigRelation(_pos_qfact_decodings);
+    _frozen_qfact_decodings[1] = CompactUSigRelation(_neg_qfact_decodings);
+    _pos_qfact_decodings.clear();
+    _pos_qfact_decodings.reserve(0);
+    _neg_qfact_decodings.clear();
+    _neg_qfact_decodings.reserve(0);
+
+    _frozen = true;
+}
+
+void Position::clearAtPastPosition() {
+    freeze();
+    _qfacts.clear();
+    _qfacts.reserve(0);
+    _expansion_substitutions.clear();
+    _expansion_substitutions.reserve(0);
     _axiomatic_ops.clear();
     _axiomatic_ops.reserve(0);
     _q_constants_type_constraints.clear();
     _q_constants_type_constraints.reserve(0);
     clearSubstitutions();
-    if (_pos_fact_supports != nullptr) delete _pos_fact_supports;
-    if (_neg_fact_supports != nullptr) delete _neg_fact_supports;
-    if (_pos_indir_fact_supports != nullptr) delete _pos_indir_fact_supports;
-    if (_neg_indir_fact_supports != nullptr) delete _neg_indir_fact_supports;
+    delete _pos_fact_supports;
+    _pos_fact_supports = nullptr;
+    delete _neg_fact_supports;
+    _neg_fact_supports = nullptr;
+    delete _pos_indir_fact_supports;
+    _pos_indir_fact_supports = nullptr;
+    delete _neg_indir_fact_supports;
+    _neg_indir_fact_supports = nullptr;
 }
 
 void Position::clearAtPastLayer() {
+    _frozen_qfact_decodings[0] = CompactUSigRelation();
+    _frozen_qfact_decodings[1] = CompactUSigRelation();
     _pos_qfact_decodings.clear();
     _pos_qfact_decodings.reserve(0);
     _neg_qfact_decodings.clear();
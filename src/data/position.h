@@ -12,6 +12,8 @@
 #include "util/log.h"
 #include "sat/literal_tree.h"
 #include "data/substitution_constraint.h"
+#include "data/compact_usig_relation.h"
+#include "util/spill_file.h"
 
 typedef NodeHashMap<USignature, IntPairTree, USignatureHasher> IndirectFactSupportMapEntry;
 typedef NodeHashMap<USignature, IndirectFactSupportMapEntry, USignatureHasher> IndirectFactSupportMap;
@@ -66,6 +68,16 @@ private:
     bool _has_primitive_ops = false;
     bool _has_nonprimitive_ops = false;
 
+    // Compact read-only replacements of _expansions / _predecessors
+    // and of the q-fact decodings [positive, negative] after freeze().
+    bool _frozen = false;
+    CompactUSigRelation _frozen_expansions;
+    CompactUSigRelation _frozen_qfact_decodings[2];
+
+    // If non-null, the operation variables have been moved to this file (see spillOpVariables()).
+    SpillFile* _spill_file = nullptr;
+    size_t _spill_offset = 0;
+
 public:
 
     Position();
@@ -88,9 +100,12 @@ public:
     void addQConstantTypeConstraint(const USignature& op, const TypeConstraint& c);
     void addSubstitutionConstraint(const USignature& op, SubstitutionConstraint&& constr);
 
-    bool hasQFactDecodings(const USignature& qFact, bool negated);
+    bool hasQFactDecodings(const USignature& qFact, bool negated) const;
+    bool hasQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) const;
+    size_t getNumQFactDecodings(const USignature& qFact, bool negated) const;
     void addQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated);
     void removeQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated);
+    // Only valid as long as the position is not frozen
     const USigSet& getQFactDecodings(const USignature& qfact, bool negated);
 
     void addAction(const USignature& action);
@@ -106,7 +121,29 @@ public:
     void removeReductionOccurrence(const USignature& reduction);
     void replaceOperation(const USignature& from, const USignature& to, Substitution&& s);
 
+    // Only valid for operations as long as the operation variables are not spilled
     const NodeHashMap<USignature, int, USignatureHasher>& getVariableTable(VarType type) const;
+    template <typename F>
+    void forEachVariable(VarType type, F f) const {
+        if (type == OP && _spill_file != nullptr) {
+            const int* words = getSpilledVariables();
+            int num = words[0];
+            const int* offsets = words+1;
+            const int* entries = offsets+num+1;
+            for (int i = 0; i < num; i++) {
+                const int* entry = entries+offsets[i];
+                USignature sig(entry[0], std::vector<int>(entry+2, entry+2+entry[1]));
+                f(sig, entry[2+entry[1]]);
+            }
+            return;
+        }
+        for (const auto& [sig, var] : type == OP ? _op_variables : _fact_variables) f(sig, var);
+    }
+    // Moves the operation variables into a read-only sorted table in the spill file.
+    // The position must not receive any new operation variables afterwards.
+    // Returns the number of bytes written to the file (0 if nothing was spilled).
+    size_t spillOpVariables(SpillFile& file);
+    bool isSpilled() const {return _spill_file != nullptr;}
     void setVariableTable(VarType type, const NodeHashMap<USignature, int, USignatureHasher>& table);
     void moveVariableTable(VarType type, Position& destination);
 
@@ -129,8 +166,37 @@ public:
 
     USigSet& getActions();
     const USigSet& getReductions() const;
+    // Only valid as long as the position is not frozen
     NodeHashMap<USignature, USigSet, USignatureHasher>& getExpansions();
     NodeHashMap<USignature, USigSet, USignatureHasher>& getPredecessors();
+
+    // Access to expansions and predecessors which remains valid after freezing
+    bool hasExpansions(const USignature& parent) const;
+    bool hasExpansion(const USignature& parent, const USignature& child) const;
+    size_t getNumExpansions(const USignature& parent) const;
+    bool hasPredecessors(const USignature& child) const;
+    bool hasPredecessor(const USignature& child, const USignature& parent) const;
+    size_t getNumPredecessors(const USignature& child) const;
+    void removePredecessor(const USignature& child, const USignature& parent);
+    template <typename F>
+    void forEachExpansion(const USignature& parent, F f) const {
+        if (_frozen) {
+            _frozen_expansions.forEachValue(parent, f);
+            return;
+        }
+        auto it = _expansions.find(parent);
+        if (it != _expansions.end()) for (const auto& child : it->second) f(child);
+    }
+    template <typename F>
+    void forEachPredecessor(const USignature& child, F f) const {
+        if (_frozen) {
+            _frozen_expansions.forEachInverse(child, f);
+            return;
+        }
+        auto it = _predecessors.find(child);
+        if (it != _predecessors.end()) for (const auto& parent : it->second) f(parent);
+    }
+
     const NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>& getExpansionSubstitutions() const;
     const USigSet& getAxiomaticOps() const;
     size_t getMaxExpansionSize() const;
@@ -139,6 +205,10 @@ public:
     size_t getPositionIndex() const;
     
     void clearAfterInstantiation();
+    // Converts expansions, predecessors and q-fact decodings into a compact read-only layout.
+    // Called once the position has been encoded and will not receive any new operations.
+    void freeze();
+    bool isFrozen() const {return _frozen;}
     void clearAtPastPosition();
     void clearAtPastLayer();
     void clearSubstitutions() {
@@ -147,19 +217,22 @@ public:
     }
 
     inline int encode(VarType type, const USignature& sig) {
+        assert(type == FACT || _spill_file == nullptr);
         auto& vars = type == OP ? _op_variables : _fact_variables;
         auto it = vars.find(sig);
         if (it == vars.end()) {
             // introduce a new variable
             assert(!VariableDomain::isLocked() || Log::e("Unknown variable %s queried!\n", VariableDomain::varName(_layer_idx, _pos, sig).c_str()));
-            int var = VariableDomain::nextVar();
+            int var = VariableDomain::nextVar(type == OP ? ROLE_OP : ROLE_FACT);
             vars[sig] = var;
             VariableDomain::printVar(var, _layer_idx, _pos, sig);
+            if (type == OP) VariableDomain::indexOpVariable(var, _layer_idx, _pos, sig);
             return var;
         } else return it->second;
     }
 
     inline int setVariable(VarType type, const USignature& sig, int var) {
+        assert(type == FACT || _spill_file == nullptr);
         auto& vars = type == OP ? _op_variables : _fact_variables;
         assert(!vars.count(sig));
         vars[sig] = var;
@@ -167,16 +240,23 @@ public:
     }
 
     inline bool hasVariable(VarType type, const USignature& sig) const {
+        if (type == OP && _spill_file != nullptr) return getSpilledVariableOrZero(sig) != 0;
         return (type == OP ? _op_variables : _fact_variables).count(sig);
     }
 
     inline int getVariable(VarType type, const USignature& sig) const {
+        if (type == OP && _spill_file != nullptr) {
+            int var = getSpilledVariableOrZero(sig);
+            assert(var != 0 || Log::e("Unknown variable %s queried!\n", VariableDomain::varName(_layer_idx, _pos, sig).c_str()));
+            return var;
+        }
         auto& vars = type == OP ? _op_variables : _fact_variables;
         assert(vars.count(sig) || Log::e("Unknown variable %s queried!\n", VariableDomain::varName(_layer_idx, _pos, sig).c_str()));
         return vars.at(sig);
     }
 
     inline int getVariableOrZero(VarType type, const USignature& sig) const {
+        if (type == OP && _spill_file != nullptr) return getSpilledVariableOrZero(sig);
         auto& vars = type == OP ? _op_variables : _fact_variables;
         const auto& it = vars.find(sig);
         if (it == vars.end()) return 0;
@@ -184,9 +264,14 @@ public:
     }
 
     inline void removeVariable(VarType type, const USignature& sig) {
+        assert(type == FACT || _spill_file == nullptr);
         auto& vars = type == OP ? _op_variables : _fact_variables;
         vars.erase(sig);
     }
+
+private:
+    const int* getSpilledVariables() const;
+    int getSpilledVariableOrZero(const USignature& sig) const;
 };
 
 
@@ -15,6 +15,7 @@
 #include "util/timer.h"
 #include "util/signal_manager.h"
 #include "util/random.h"
+#include "util/trace.h"
 
 #ifndef LILOTANE_VERSION
 #define LILOTANE_VERSION "(dbg)"
@@ -49,10 +50,20 @@ void outputBanner(bool colors) {
 
 
 
+std::string traceFile;
+
+void dumpTrace() {
+    Trace::dump(traceFile);
+}
+
 void handleSignal(int signum) {
     SignalManager::signalExit();
 }
 
+void handleStatusSignal([[maybe_unused]] int signum) {
+    SignalManager::signalStatusRequest();
+}
+
 void run(Parameters& params) {
 
     HtnInstance htn(params);
@@ -72,6 +83,7 @@ int main(int argc, char** argv) {
     
     signal(SIGTERM, handleSignal);
     signal(SIGINT, handleSignal);
+    signal(SIGUSR1, handleStatusSignal);
 
     Timer::init();
 
@@ -92,6 +104,17 @@ int main(int argc, char** argv) {
         Log::log_notime(Log::V0_ESSENTIAL, "\n");
     }
 
+    if (!params.getParam("tf").empty()) {
+#ifdef LILOTANE_TRACE
+        Trace::init(params.getIntParam("tfs"));
+        // Dump the trace on each way out, including exit() upon time limits and signals
+        traceFile = params.getParam("tf");
+        atexit(dumpTrace);
+#else
+        Log::w("Tracing was not compiled in; rebuild with -DLILOTANE_TRACE=1 to use -tf.\n");
+#endif
+    }
+
     if (params.isSet("h") || params.isSet("help")) {
         params.printUsage();
         exit(0);
@@ -0,0 +1,73 @@
+
+#include <algorithm>
+
+#include "sat/at_most_one.h"
+#include "sat/binary_amo.h"
+#include "sat/sequential_amo.h"
+#include "sat/commander_amo.h"
+#include "sat/product_amo.h"
+
+// Groups up to this size are always encoded pairwise
+const size_t MAX_AUTO_PAIRWISE_SIZE = 6;
+
+AtMostOne::AtMostOne(Parameters& params, const std::string& solverSignature) : 
+        _mode(params.getIntParam("amo")), _binary_threshold(params.getIntParam("bamot")) {
+
+    // Does the solver eliminate helper variables by itself (bounded variable elimination during inprocessing)?
+    std::string sig = solverSignature;
+    std::transform(sig.begin(), sig.end(), sig.begin(), ::tolower);
+    _inprocessing_solver = false;
+    for (const char* name : {"cadical", "lingeling", "cryptominisat", "riss"}) {
+        if (sig.find(name) != std::string::npos) _inprocessing_solver = true;
+    }
+}
+
+int AtMostOne::select(size_t groupSize) const {
+    switch (_mode) {
+    case AMO_PAIRWISE_OR_BINARY: 
+        return (int)groupSize >= _binary_threshold ? AMO_BINARY : AMO_PAIRWISE;
+    case AMO_SEQUENTIAL:
+    case AMO_COMMANDER:
+    case AMO_PRODUCT:
+        return _mode;
+    default:
+        // Small groups: no helper variables needed
+        if (groupSize <= MAX_AUTO_PAIRWISE_SIZE) return AMO_PAIRWISE;
+        // Large groups: fewest helper variables while retaining good propagation
+        if ((int)groupSize >= _binary_threshold) return AMO_PRODUCT;
+        // Medium groups: the sequential counter propagates best, but introduces a helper variable 
+        // per element -- only afford this if the solver can eliminate them again
+        return _inprocessing_solver ? AMO_SEQUENTIAL : AMO_COMMANDER;
+    }
+}
+
+std::vector<std::vector<int>> AtMostOne::encode(int encoding, const std::vector<int>& vars) const {
+    std::vector<std::vector<int>> cls;
+    if (vars.size() <= 1) return cls;
+    switch (encoding) {
+    case AMO_BINARY:
+        return BinaryAtMostOne(vars, vars.size()+1).encode();
+    case AMO_SEQUENTIAL:
+        return SequentialAtMostOne(vars).encode();
+    case AMO_COMMANDER:
+        return CommanderAtMostOne(vars).encode();
+    case AMO_PRODUCT:
+        return ProductAtMostOne(vars).encode();
+    default:
+        for (size_t i = 0; i < vars.size(); i++) 
+            for (size_t j = i+1; j < vars.size(); j++) 
+                cls.push_back({-vars[i], -vars[j]});
+        return cls;
+    }
+}
+
+const char* AtMostOne::getName(int encoding) {
+    switch (encoding) {
+    case AMO_PAIRWISE: return "pairwise";
+    case AMO_BINARY: return "binary";
+    case AMO_SEQUENTIAL: return "sequential";
+    case AMO_COMMANDER: return "commander";
+    case AMO_PRODUCT: return "product";
+    default: return "auto";
+    }
+}
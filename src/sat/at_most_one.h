@@ -0,0 +1,39 @@
+
+#ifndef DOMPASCH_LILOTANE_AT_MOST_ONE_H
+#define DOMPASCH_LILOTANE_AT_MOST_ONE_H
+
+#include <vector>
+#include <string>
+
+#include "util/params.h"
+
+const int AMO_AUTO = 0;
+const int AMO_PAIRWISE_OR_BINARY = 1;
+const int AMO_SEQUENTIAL = 2;
+const int AMO_COMMANDER = 3;
+const int AMO_PRODUCT = 4;
+
+// Concrete encodings which can result from a selection
+const int AMO_PAIRWISE = 5;
+const int AMO_BINARY = 6;
+
+/*
+Selects and performs an at-most-one encoding for a group of variables.
+*/
+class AtMostOne {
+
+private:
+    int _mode;
+    int _binary_threshold;
+    bool _inprocessing_solver;
+
+public:
+    AtMostOne(Parameters& params, const std::string& solverSignature);
+
+    int select(size_t groupSize) const;
+    std::vector<std::vector<int>> encode(int encoding, const std::vector<int>& vars) const;
+
+    static const char* getName(int encoding);
+};
+
+#endif
@@ -0,0 +1,49 @@
+
+#include <algorithm>
+
+#include "commander_amo.h"
+
+#include "variable_domain.h"
+#include "util/log.h"
+
+CommanderAtMostOne::CommanderAtMostOne(const std::vector<int>& states, size_t groupSize) : 
+        _states(states), _group_size(groupSize < 2 ? 2 : groupSize) {}
+
+std::vector<std::vector<int>> CommanderAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    encode(_states, cls);
+    return cls;
+}
+
+void CommanderAtMostOne::encode(const std::vector<int>& states, std::vector<std::vector<int>>& cls) {
+
+    if (states.size() <= _group_size + 1) {
+        // Naive at-most-one
+        for (size_t i = 0; i < states.size(); i++) 
+            for (size_t j = i+1; j < states.size(); j++) 
+                cls.push_back({-states[i], -states[j]});
+        return;
+    }
+
+    std::vector<int> commanders;
+    for (size_t begin = 0; begin < states.size(); begin += _group_size) {
+        size_t end = std::min(begin + _group_size, states.size());
+        int cmd = VariableDomain::nextVar(ROLE_IMPLIED_HELPER);
+        Log::d("VARMAP %i (__camo_%i-%i_%i)\n", cmd, states[0], states[states.size()-1], commanders.size());
+        commanders.push_back(cmd);
+
+        std::vector<int> ifCommanderThenSomeState(1, -cmd);
+        for (size_t i = begin; i < end; i++) {
+            // At most one state of the group
+            for (size_t j = i+1; j < end; j++) cls.push_back({-states[i], -states[j]});
+            // State implies its commander
+            cls.push_back({-states[i], cmd});
+            ifCommanderThenSomeState.push_back(states[i]);
+        }
+        // Commander implies some state of its group
+        cls.push_back(std::move(ifCommanderThenSomeState));
+    }
+
+    // At most one commander
+    encode(commanders, cls);
+}
@@ -0,0 +1,27 @@
+
+#ifndef DOMPASCH_LILOTANE_COMMANDER_AMO_H
+#define DOMPASCH_LILOTANE_COMMANDER_AMO_H
+
+#include <vector>
+
+/*
+Commander at-most-one encoding (Klieber & Kwon 2007):
+The states are partitioned into groups of a fixed size, each of which
+is represented by a commander variable. At most one state per group and
+at most one commander (recursively) may be true.
+*/
+class CommanderAtMostOne {
+
+private:
+    std::vector<int> _states;
+    size_t _group_size;
+
+public:
+    CommanderAtMostOne(const std::vector<int>& states, size_t groupSize = 3);
+    std::vector<std::vector<int>> encode();
+
+private:
+    void encode(const std::vector<int>& states, std::vector<std::vector<int>>& cls);
+};
+
+#endif
@@ -16,6 +16,9 @@ private:
     SatInterface& _sat;
     VariableProvider& _vars;
 
+    // Operations which hold in the current model, per layer and position
+    std::vector<std::vector<std::vector<std::pair<USignature, int>>>> _true_ops;
+
 public:
     Decoder(HtnInstance& htn, std::vector<Layer*>& layers, SatInterface& sat, VariableProvider& vars) :
         _htn(htn), _layers(layers), _sat(sat), _vars(vars) {}
@@ -27,21 +30,25 @@ public:
         int li = finalLayer.index();
         //VariableDomain::lock();
 
+        collectTrueOperations();
+
         std::vector<PlanItem> plan(finalLayer.size());
         //log("(actions at layer %i)\n", li);
         for (size_t pos = 0; pos < finalLayer.size(); pos++) {
             //log("%i\n", pos);
 
             // Print out the state
-            Log::d("PLANDBG %i,%i S ", li, pos);
-            for (const auto& [sig, fVar] : finalLayer[pos].getVariableTable(VarType::FACT)) {
-                if (_sat.holds(fVar)) Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(sig));
+            if (Log::isEnabled(Log::V4_DEBUG)) {
+                Log::d("PLANDBG %i,%i S ", li, pos);
+                for (const auto& [sig, fVar] : finalLayer[pos].getVariableTable(VarType::FACT)) {
+                    if (_sat.holds(fVar)) Log::log_notime(Log::V4_DEBUG, "%s ", TOSTR(sig));
+                }
+                Log::log_notime(Log::V4_DEBUG, "\n");
             }
-            Log::log_notime(Log::V4_DEBUG, "\n");
 
             int chosenActions = 0;
             //State newState = state;
-            for (const auto& [sig, aVar] : finalLayer[pos].getVariableTable(VarType::OP)) {
+            for (const auto& [sig, aVar] : _true_ops[li][pos]) {
                 if (!_sat.holds(aVar)) continue;
 
                 USignature aSig = sig;
@@ -55,7 +62,7 @@ public:
 
                 chosenActions++;
                 
-                Log::d("PLANDBG %i,%i A %s\n", li, pos, TOSTR(aSig));
+                LOG_D("PLANDBG %i,%i A %s\n", li, pos, TOSTR(aSig));
 
                 // Decode q constants
                 USignature aDec = getDecodedQOp(li, pos, aSig);
@@ -100,7 +107,7 @@ public:
                 int actionsThisPos = 0;
                 int reductionsThisPos = 0;
 
-                for (const auto& [opSig, v] : l[pos].getVariableTable(VarType::OP)) {
+                for (const auto& [opSig, v] : _true_ops[layerIdx][pos]) {
 
                     if (_sat.holds(v)) {
 
@@ -119,7 +126,7 @@ public:
 
                             // TODO check this is a valid subtask relationship
 
-                            Log::d("[%i] %s @ (%i,%i)\n", v, TOSTR(aSig), layerIdx, pos);                    
+                            LOG_D("[%i] %s @ (%i,%i)\n", v, TOSTR(aSig), layerIdx, pos);                    
 
                             // Find the actual action variable at the final layer, not at this (inner) layer
                             size_t l = layerIdx;
@@ -150,7 +157,7 @@ public:
                             if (decRSig == Sig::NONE_SIG) continue;
 
                             Reduction rDecoded = r.substituteRed(Substitution(r.getArguments(), decRSig._args));
-                            Log::d("[%i] %s:%s @ (%i,%i)\n", v, TOSTR(rDecoded.getTaskSignature()), TOSTR(decRSig), layerIdx, pos);
+                            LOG_D("[%i] %s:%s @ (%i,%i)\n", v, TOSTR(rDecoded.getTaskSignature()), TOSTR(decRSig), layerIdx, pos);
 
                             if (layerIdx == 0) {
                                 // Initial reduction
@@ -162,6 +169,15 @@ public:
                                 continue;
                             }
 
+                            if (_layers.at(layerIdx-1)->isExpansionDeferred(predPos) && !r.getSubtasks().empty()) {
+                                // Reduction repeated from a position whose expansion was deferred: 
+                                // carry over the parent's plan item
+                                itemsNewLayer[pos] = itemsOldLayer[predPos];
+                                itemsOldLayer[predPos] = PlanItem();
+                                reductionsThisPos++;
+                                continue;
+                            }
+
                             // Lookup parent reduction
                             Reduction parentRed;
                             size_t offset = pos - _layers.at(layerIdx-1)->getSuccessorPos(predPos);
@@ -184,7 +200,7 @@ public:
                                 itemsOldLayer[predPos].subtaskIds.push_back(v);
                                 reductionsThisPos++;
                             } else {
-                                Log::d(" -- invalid : %s != %s\n", TOSTR(parentRed.getSubtasks()[offset]), TOSTR(rDecoded.getTaskSignature()));
+                                LOG_D(" -- invalid : %s != %s\n", TOSTR(parentRed.getSubtasks()[offset]), TOSTR(rDecoded.getTaskSignature()));
                             }
                         }
                     }
@@ -208,9 +224,56 @@ public:
         return result;
     }
 
+    void collectTrueOperations() {
+
+        _true_ops.resize(_layers.size());
+        for (size_t l = 0; l < _layers.size(); l++) {
+            _true_ops[l].clear();
+            _true_ops[l].resize(_layers[l]->size());
+        }
+
+        if (VariableDomain::isOpVariableIndexed()) {
+            // Without predecessor clauses, a true operation does not need to have a true parent:
+            // Scan the reverse index of all operation variables
+            VariableDomain::getOpVariableIndex().forEachIf([&](int var) {return _sat.holds(var);}, 
+                    [&](int var, int layer, int pos, const USignature& sig) {
+                _true_ops[layer][pos].emplace_back(sig, var);
+            });
+            return;
+        }
+
+        // Each true operation has a true parent, so it suffices to follow
+        // the expansions of true operations from the initial layer downwards
+        Layer& initLayer = *_layers[0];
+        for (size_t pos = 0; pos < initLayer.size(); pos++) {
+            initLayer[pos].forEachVariable(VarType::OP, [&](const USignature& sig, int var) {
+                if (_sat.holds(var)) _true_ops[0][pos].emplace_back(sig, var);
+            });
+        }
+        for (size_t layerIdx = 0; layerIdx+1 < _layers.size(); layerIdx++) {
+            Layer& layer = *_layers[layerIdx];
+            Layer& below = *_layers[layerIdx+1];
+            for (size_t pos = 0; pos < layer.size(); pos++) {
+                size_t endPos = pos+1 < layer.size() ? layer.getSuccessorPos(pos+1) : below.size();
+                for (const auto& [parent, parentVar] : _true_ops[layerIdx][pos]) {
+                    for (size_t belowPos = layer.getSuccessorPos(pos); belowPos < endPos; belowPos++) {
+                        Position& child = below[belowPos];
+                        auto& trueOps = _true_ops[layerIdx+1][belowPos];
+                        child.forEachExpansion(parent, [&](const USignature& sig) {
+                            int var = child.getVariableOrZero(VarType::OP, sig);
+                            if (var == 0 || !_sat.holds(var)) return;
+                            for (const auto& [otherSig, otherVar] : trueOps) if (otherVar == var) return;
+                            trueOps.emplace_back(sig, var);
+                        });
+                    }
+                }
+            }
+        }
+    }
+
     bool value(VarType type, int layer, int pos, const USignature& sig) {
         int v = _vars.getVariable(type, layer, pos, sig);
-        Log::d("VAL %s@(%i,%i)=%i %i\n", TOSTR(sig), layer, pos, v, _sat.holds(v));
+        LOG_D("VAL %s@(%i,%i)=%i %i\n", TOSTR(sig), layer, pos, v, _sat.holds(v));
         return _sat.holds(v);
     }
 
@@ -230,19 +293,19 @@ public:
                 for (int argSubst : _htn.getDomainOfQConstant(arg)) {
                     const USignature& sigSubst = _vars.sigSubstitute(arg, argSubst);
                     if (_vars.isEncodedSubstitution(sigSubst) && _sat.holds(_vars.varSubstitution(arg, argSubst))) {
-                        Log::d("SUBSTVAR [%s/%s] TRUE => %s ~~> ", TOSTR(arg), TOSTR(argSubst), TOSTR(sig));
+                        LOG_D("SUBSTVAR [%s/%s] TRUE => %s ~~> ", TOSTR(arg), TOSTR(argSubst), TOSTR(sig));
                         numSubstitutions++;
                         Substitution sub;
                         sub[arg] = argSubst;
                         sig.apply(sub);
-                        Log::d("%s\n", TOSTR(sig));
+                        LOG_D("%s\n", TOSTR(sig));
                     } else {
                         //Log::d("%i FALSE\n", varSubstitution(sigSubst));
                     }
                 }
 
                 if (numSubstitutions == 0) {
-                    Log::v("(%i,%i) No substitutions for arg %s of %s\n", layer, pos, TOSTR(arg), TOSTR(origSig));
+                    LOG_V("(%i,%i) No substitutions for arg %s of %s\n", layer, pos, TOSTR(arg), TOSTR(origSig));
                     return Sig::NONE_SIG;
                 }
                 assert(numSubstitutions == 1 || Log::e("%i substitutions for arg %s of %s\n", numSubstitutions, TOSTR(arg), TOSTR(origSig)));
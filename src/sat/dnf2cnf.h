@@ -2,69 +2,137 @@
 #ifndef DOMPASCH_LILOTANE_DNF_2_CNF_H
 #define DOMPASCH_LILOTANE_DNF_2_CNF_H
 
-#include <set>
 #include <vector>
+#include <limits>
 #include <assert.h>
 
 #include "util/log.h"
+#include "sat/variable_domain.h"
 
+/*
+A DNF is given as a flat vector of literals where each term is terminated by a 0.
+*/
 class Dnf2Cnf {
 
 public:
-    static std::set<std::set<int>> getCnf(const std::vector<int>& dnf) {
-        std::set<std::set<int>> cnf;
+    /*
+    Encodes the clause (headerLits OR dnf), calling emit(const std::vector<int>&) for each resulting clause.
+    Uses the distributive law if it does not produce more clauses than a Tseitin encoding,
+    and a Tseitin encoding with a helper variable per non-unit term otherwise.
+    */
+    template <typename Emitter>
+    static void encode(const std::vector<int>& dnf, const std::vector<int>& headerLits, Emitter emit) {
+        if (dnf.empty()) return;
+        if (getDistributiveSize(dnf) <= getTseitinSize(dnf)) {
+            encodeDistributive(dnf, headerLits, emit);
+        } else {
+            encodeTseitin(dnf, headerLits, emit);
+        }
+    }
 
-        if (dnf.empty()) return cnf;
+    // Number of clauses produced by the distributive law (saturating)
+    static size_t getDistributiveSize(const std::vector<int>& dnf) {
+        size_t size = 1;
+        size_t termSize = 0;
+        for (int lit : dnf) {
+            if (lit != 0) {
+                termSize++;
+                continue;
+            }
+            if (termSize > 0) {
+                size = size > std::numeric_limits<size_t>::max() / termSize ?
+                        std::numeric_limits<size_t>::max() : size * termSize;
+            }
+            termSize = 0;
+        }
+        return size;
+    }
 
-        int size = 1;
-        int clsSize = 0;
-        std::vector<int> clsStarts;
-        for (size_t i = 0; i < dnf.size(); i++) {
-            if (dnf[i] == 0) {
-                size *= clsSize;
-                clsSize = 0;
-            } else {
-                if (clsSize == 0) clsStarts.push_back(i);
-                clsSize++;
+    // Number of clauses produced by the Tseitin encoding
+    static size_t getTseitinSize(const std::vector<int>& dnf) {
+        size_t size = 1;
+        size_t termSize = 0;
+        for (int lit : dnf) {
+            if (lit != 0) {
+                termSize++;
+                continue;
             }
+            if (termSize > 1) size += termSize;
+            termSize = 0;
         }
-        assert(size > 0);
+        return size;
+    }
 
-        // Iterate over all possible combinations
-        std::vector<int> counter(clsStarts.size(), 0);
+    template <typename Emitter>
+    static void encodeDistributive(const std::vector<int>& dnf, const std::vector<int>& headerLits, Emitter emit) {
+
+        std::vector<size_t> termStarts;
+        bool termStart = true;
+        for (size_t i = 0; i < dnf.size(); i++) {
+            if (dnf[i] != 0 && termStart) termStarts.push_back(i);
+            termStart = dnf[i] == 0;
+        }
+        if (termStarts.empty()) return;
+
+        // Iterate over all combinations of one literal per term
+        std::vector<size_t> counter(termStarts);
+        std::vector<int> cls;
         while (true) {
-            // Assemble the combination
-            std::set<int> newCls;
-            for (size_t pos = 0; pos < counter.size(); pos++) {
-                const int& lit = dnf[clsStarts[pos]+counter[pos]];
-                assert(lit != 0);
-                newCls.insert(lit);
+            // Assemble the clause, skipping duplicate literals and tautologies
+            cls = headerLits;
+            bool tautology = false;
+            for (size_t idx : counter) {
+                int lit = dnf[idx];
+                bool duplicate = false;
+                for (int other : cls) {
+                    if (other == lit) duplicate = true;
+                    if (other == -lit) tautology = true;
+                }
+                if (tautology) break;
+                if (!duplicate) cls.push_back(lit);
             }
-            cnf.insert(newCls);            
+            if (!tautology) emit(cls);
 
-            // Increment exponential counter
+            // Increment counter
             size_t x = 0;
-            while (x < counter.size()) {
-                if (dnf[clsStarts[x]+counter[x]+1] == 0) {
-                    // max value reached
-                    counter[x] = 0;
-                    if (x+1 == counter.size()) break;
-                } else {
-                    // increment
+            for (; x < counter.size(); x++) {
+                if (dnf[counter[x]+1] != 0) {
                     counter[x]++;
                     break;
                 }
-                x++;
+                counter[x] = termStarts[x];
             }
-
-            // Counter finished?
-            if (counter[x] == 0 && x+1 == counter.size()) break;
+            if (x == counter.size()) break;
         }
+    }
 
-        if (cnf.size() > 1000) Log::w("CNF of size %i generated\n", cnf.size());
-        //else Log::d("CNF of size %i generated\n", cnf.size());
+    template <typename Emitter>
+    static void encodeTseitin(const std::vector<int>& dnf, const std::vector<int>& headerLits, Emitter emit) {
 
-        return cnf;
+        // Main clause: header or some term holds
+        std::vector<int> mainCls(headerLits);
+        std::vector<int> implication(2);
+        size_t termStart = 0;
+        for (size_t i = 0; i < dnf.size(); i++) {
+            if (dnf[i] != 0) continue;
+            size_t termSize = i - termStart;
+            if (termSize == 1) {
+                // Unit term: no helper variable needed
+                mainCls.push_back(dnf[termStart]);
+            } else if (termSize > 1) {
+                // Helper variable implies each literal of the term
+                int var = VariableDomain::nextVar();
+                Log::d("VARMAP %i (__dnf_%i_%i)\n", var, dnf[termStart], termSize);
+                for (size_t j = termStart; j < i; j++) {
+                    implication[0] = -var;
+                    implication[1] = dnf[j];
+                    emit(implication);
+                }
+                mainCls.push_back(var);
+            }
+            termStart = i+1;
+        }
+        emit(mainCls);
     }
 };
 
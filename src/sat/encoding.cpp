@@ -1,17 +1,19 @@
 
 #include <random>
+#include <algorithm>
 
 #include "sat/encoding.h"
 #include "sat/literal_tree.h"
-#include "sat/binary_amo.h"
 #include "sat/dnf2cnf.h"
 #include "util/log.h"
 #include "util/timer.h"
+#include "util/trace.h"
 
 void Encoding::encode(size_t layerIdx, size_t pos) {
+    TRACE_SCOPE("encoding");
     _termination_callback();
 
-    _stats.beginPosition();
+    _stats.beginPosition(layerIdx, pos);
 
     _layer_idx = layerIdx;
     _pos = pos;
@@ -70,6 +72,10 @@ void Encoding::encode(size_t layerIdx, size_t pos) {
     }
     _stats.end(STAGE_AXIOMATICOPS);
 
+    // Guide the solver towards the previous layer's model
+    if (_phase_hints && hasAbove && (int)layerIdx == _hint_layer_idx+1) 
+        encodePhaseHints(newPos, above);
+
     _stats.endPosition();
 }
 
@@ -160,15 +166,14 @@ void Encoding::encodeFactVariables(Position& newPos, Position& left, Position& a
     auto reuseQFact = [&](const USignature& qfact, int var, Position& otherPos, bool negated) {
         if (!newPos.hasQFactDecodings(qfact, negated)) return true;
         if (var == 0 || !otherPos.hasQFactDecodings(qfact, negated)
-                || otherPos.getQFactDecodings(qfact, negated).size() < newPos.getQFactDecodings(qfact, negated).size())
+                || otherPos.getNumQFactDecodings(qfact, negated) < newPos.getNumQFactDecodings(qfact, negated))
             return false;
-        const auto& otherDecodings = otherPos.getQFactDecodings(qfact, negated);
         for (const auto& decFact : newPos.getQFactDecodings(qfact, negated)) {
             int decFactVar = newPos.getVariableOrZero(VarType::FACT, decFact);
             int otherDecFactVar = otherPos.getVariableOrZero(VarType::FACT, decFact);
             if (decFactVar == 0 || otherDecFactVar == 0 
                     || decFactVar != otherDecFactVar 
-                    || !otherDecodings.count(decFact)) {
+                    || !otherPos.hasQFactDecoding(qfact, decFact, negated)) {
                 return false;
             }
         }
@@ -215,7 +220,7 @@ void Encoding::encodeFactVariables(Position& newPos, Position& left, Position& a
             // Variable is already encoded. If the variable is new, constrain it.
             if (_new_fact_vars.count(var)) _sat.addClause((i == 0 ? 1 : -1) * var);
         }
-        Log::d("(%i,%i) DEFFACT %s\n", _layer_idx, _pos, TOSTR(factSig));
+        LOG_D("(%i,%i) DEFFACT %s\n", _layer_idx, _pos, TOSTR(factSig));
     }
     _stats.end(STAGE_TRUEFACTS);
 }
@@ -246,8 +251,21 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
     Supports* supp[2] = {&newPos.getNegFactSupports(), &newPos.getPosFactSupports()};
     IndirectFactSupportMap* iSupp[2] = {&newPos.getNegIndirectFactSupports(), &newPos.getPosIndirectFactSupports()};
 
+    if (_lazy_frame_axioms) {
+        collectPreconditionFacts(newPos);
+        // Runs of deferred frame axioms do not continue into a new layer;
+        // runs of past layers which have been added completely are dropped
+        if (layerIdx != _deferred_runs_layer) {
+            _open_deferred_runs.clear();
+            _deferred_runs.erase(std::remove_if(_deferred_runs.begin(), _deferred_runs.end(), 
+                    [](const std::vector<int>& run) {return run.empty();}), _deferred_runs.end());
+            _deferred_runs_layer = layerIdx;
+        }
+    }
+
     // Find and encode frame axioms for each applicable fact from the left
     size_t skipped = 0;
+    size_t deferred = 0;
     for ([[maybe_unused]] const auto& [fact, var] : left.getVariableTable(VarType::FACT)) {
         if (_htn.hasQConstants(fact)) continue;
         
@@ -299,6 +317,24 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
         if (!hasPrimitiveOps) continue;
         skipped--;
 
+        // Defer frame axioms if no operation here depends on the fact:
+        // append them to the fact's current run of deferred frame axioms
+        std::vector<int>* deferTo = nullptr;
+        if (_lazy_frame_axioms) {
+            if (_precondition_facts.count(fact)) {
+                // Encoded eagerly: ends the fact's current run
+                _open_deferred_runs.erase(fact);
+            } else {
+                auto it = _open_deferred_runs.find(fact);
+                if (it == _open_deferred_runs.end()) {
+                    it = _open_deferred_runs.emplace(fact, _deferred_runs.size()).first;
+                    _deferred_runs.emplace_back();
+                }
+                deferTo = &_deferred_runs[it->second];
+                deferred++;
+            }
+        }
+
         // Encode general frame axioms for this fact
         int i = -1;
         for (int sign = -1; sign <= 1; sign += 2) {
@@ -327,11 +363,11 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
                         int virtOpVar = left.getVariableOrZero(VarType::OP, virtOp);
                         if (opVar != 0) {
                             cls.push_back(opVar);
-                            encodeIndirectFrameAxioms(headerLits, opVar, tree);
+                            encodeIndirectFrameAxioms(headerLits, opVar, tree, deferTo);
                         }
                         if (virtOpVar != 0) {
                             cls.push_back(virtOpVar);
-                            encodeIndirectFrameAxioms(headerLits, virtOpVar, tree);
+                            encodeIndirectFrameAxioms(headerLits, virtOpVar, tree, deferTo);
                         }
                     }
                 }
@@ -344,15 +380,21 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
                     if (virtOpVar != 0) cls.push_back(virtOpVar);
                 }
             }
-            _sat.addClause(cls);
+            if (deferTo != nullptr) {
+                deferTo->insert(deferTo->end(), cls.begin(), cls.end());
+                deferTo->push_back(0);
+                _num_deferred_frame_axioms++;
+                _num_deferred_frame_axioms_total++;
+            } else _sat.addClause(cls);
         }
     }
     _stats.end(STAGE_DIRECTFRAMEAXIOMS);
 
-    Log::d("Skipped %i frame axioms\n", skipped);
+    Log::d("Skipped %i frame axioms, deferred %i\n", skipped, deferred);
 }
 
-void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int opVar, const IntPairTree& tree) {
+void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int opVar, const IntPairTree& tree, 
+            std::vector<int>* deferTo) {
        
     // Unconditional effect?
     if (tree.containsEmpty()) return;
@@ -361,6 +403,17 @@ void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int
             
     // Transform header and tree into a set of clauses
     for (const auto& cls : tree.encode()) {
+        if (deferTo != nullptr) {
+            for (int lit : headerLits) deferTo->push_back(lit);
+            deferTo->push_back(-opVar);
+            for (const auto& [src, dest] : cls) {
+                deferTo->push_back((src<0 ? -1 : 1) * _vars.varSubstitution(std::abs(src), dest));
+            }
+            deferTo->push_back(0);
+            _num_deferred_frame_axioms++;
+            _num_deferred_frame_axioms_total++;
+            continue;
+        }
         for (int lit : headerLits) _sat.appendClause(lit);
         _sat.appendClause(-opVar);
         for (const auto& [src, dest] : cls) {
@@ -372,6 +425,76 @@ void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int
     _stats.end(STAGE_INDIRECTFRAMEAXIOMS);
 }
 
+void Encoding::collectPreconditionFacts(Position& pos) {
+    _precondition_facts.clear();
+    auto collect = [&](const SigSet& pres) {
+        for (const Signature& pre : pres) {
+            if (!_htn.hasQConstants(pre._usig)) {
+                _precondition_facts.insert(pre._usig);
+            } else if (pos.hasQFactDecodings(pre._usig, pre._negated)) {
+                for (const USignature& decFact : pos.getQFactDecodings(pre._usig, pre._negated))
+                    _precondition_facts.insert(decFact);
+            }
+        }
+    };
+    for (const USignature& aSig : pos.getActions()) {
+        if (_htn.isActionRepetition(aSig._name_id)) continue;
+        collect(_htn.getOpTable().getAction(aSig).getPreconditions());
+    }
+    for (const USignature& rSig : pos.getReductions()) {
+        collect(_htn.getOpTable().getReduction(rSig).getPreconditions());
+    }
+}
+
+size_t Encoding::addViolatedFrameAxioms() {
+
+    // A violated frame axiom adds the entire run of deferred frame axioms it belongs to:
+    // otherwise, the fact's change could just move to a neighboring position in each iteration
+    if (_num_deferred_frame_axioms == 0) return 0;
+    _stats.begin(STAGE_DIRECTFRAMEAXIOMS);
+    size_t numAdded = 0;
+    for (auto& run : _deferred_runs) {
+        if (run.empty()) continue;
+        bool violated = false;
+        bool satisfied = false;
+        for (int lit : run) {
+            if (lit == 0) {
+                if (!satisfied) {
+                    violated = true;
+                    break;
+                }
+                satisfied = false;
+            } else if (!satisfied) satisfied = _sat.holds(lit);
+        }
+        if (violated) numAdded += addDeferredRun(run);
+    }
+    _stats.end(STAGE_DIRECTFRAMEAXIOMS);
+    return numAdded;
+}
+
+void Encoding::addDeferredFrameAxioms() {
+    _stats.begin(STAGE_DIRECTFRAMEAXIOMS);
+    for (auto& run : _deferred_runs) addDeferredRun(run);
+    _deferred_runs.clear();
+    _open_deferred_runs.clear();
+    _stats.end(STAGE_DIRECTFRAMEAXIOMS);
+}
+
+size_t Encoding::addDeferredRun(std::vector<int>& run) {
+    size_t numClauses = 0;
+    for (int lit : run) {
+        if (lit == 0) {
+            _sat.endClause();
+            numClauses++;
+        } else _sat.appendClause(lit);
+    }
+    // Later deferred frame axioms of the fact may still be appended to the run
+    run.clear();
+    run.shrink_to_fit();
+    _num_deferred_frame_axioms -= numClauses;
+    return numClauses;
+}
+
 void Encoding::encodeOperationConstraints(Position& newPos) {
 
     size_t layerIdx = newPos.getLayerIndex();
@@ -418,25 +541,9 @@ void Encoding::encodeOperationConstraints(Position& newPos) {
     
     if (numOccurringOps == 0) return;
 
-    if ((int)elementVars.size() >= _params.getIntParam("bamot")) {
-        // Binary at-most-one
-
-        _stats.begin(STAGE_ATMOSTONEELEMENT);
-        auto bamo = BinaryAtMostOne(elementVars, elementVars.size()+1);
-        for (const auto& c : bamo.encode()) _sat.addClause(c);
-        _stats.end(STAGE_ATMOSTONEELEMENT);
-
-    } else {
-        // Naive at-most-one
-
-        _stats.begin(STAGE_ATMOSTONEELEMENT);
-        for (size_t i = 0; i < elementVars.size(); i++) {
-            for (size_t j = i+1; j < elementVars.size(); j++) {
-                _sat.addClause(-elementVars[i], -elementVars[j]);
-            }
-        }
-        _stats.end(STAGE_ATMOSTONEELEMENT);
-    }
+    _stats.begin(STAGE_ATMOSTONEELEMENT);
+    encodeAtMostOne(elementVars);
+    _stats.end(STAGE_ATMOSTONEELEMENT);
 }
 
 void Encoding::encodeSubstitutionVars(const USignature& opSig, int opVar, int arg) {
@@ -467,18 +574,25 @@ void Encoding::encodeSubstitutionVars(const USignature& opSig, int opVar, int ar
     _sat.endClause();
 
     // AT MOST ONE substitution
-    if ((int)substitutionVars.size() >= _params.getIntParam("bamot")) {
-        // Binary at-most-one
-        auto bamo = BinaryAtMostOne(substitutionVars, substitutionVars.size()+1);
-        for (const auto& c : bamo.encode()) _sat.addClause(c);
-    } else {
-        // Naive at-most-one
-        for (int vSub1 : substitutionVars) {
-            for (int vSub2 : substitutionVars) {
-                if (vSub1 < vSub2) _sat.addClause(-vSub1, -vSub2);
+    encodeAtMostOne(substitutionVars);
+}
+
+void Encoding::encodeAtMostOne(const std::vector<int>& vars) {
+    if (vars.size() <= 1) return;
+
+    int encoding = _amo.select(vars.size());
+    _stats.addAtMostOne(AtMostOne::getName(encoding));
+
+    if (encoding == AMO_PAIRWISE) {
+        // Naive at-most-one: add clauses directly
+        for (size_t i = 0; i < vars.size(); i++) {
+            for (size_t j = i+1; j < vars.size(); j++) {
+                _sat.addClause(-vars[i], -vars[j]);
             }
         }
+        return;
     }
+    for (const auto& c : _amo.encode(encoding, vars)) _sat.addClause(c);
 }
 
 void Encoding::encodeQFactSemantics(Position& newPos) {
@@ -524,7 +638,7 @@ void Encoding::encodeQFactSemantics(Position& newPos) {
                 
                 int decFactVar = newPos.getVariableOrZero(VarType::FACT, decFactSig);
                 if (decFactVar == 0) continue;
-                if (filterAbove && above.getQFactDecodings(qfactSig, negated).count(decFactSig)) continue;
+                if (filterAbove && above.hasQFactDecoding(qfactSig, decFactSig, negated)) continue;
 
                 // Assemble list of substitution variables
                 for (size_t i = 0; i < qfactSig._args.size(); i++) {
@@ -618,12 +732,10 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
                     for (int lit : set) dnf.push_back(lit);
                     dnf.push_back(0);
                 }
-                auto cnf = Dnf2Cnf::getCnf(dnf);
-                for (const auto& clause : cnf) {
-                    _sat.appendClause(-aVar, -_vars.getVariable(VarType::FACT, newPos, eff._usig));
-                    for (int lit : clause) _sat.appendClause(lit);
-                    _sat.endClause();
-                }
+                std::vector<int> headerLits;
+                headerLits.push_back(-aVar);
+                headerLits.push_back(-_vars.getVariable(VarType::FACT, newPos, eff._usig));
+                Dnf2Cnf::encode(dnf, headerLits, [&](const std::vector<int>& cls) {_sat.addClause(cls);});
             }
         }
     }
@@ -755,6 +867,41 @@ void Encoding::encodeSubtaskRelationships(Position& newPos, Position& above) {
     }
 }
 
+void Encoding::encodePhaseHints(Position& newPos, Position& above) {
+
+    auto heldAbove = [&](int var) {
+        return var > 0 && var < (int)_hint_model.size() && _hint_model[var];
+    };
+
+    // Prefer a child of the operation which held at the above position;
+    // all other operations are preferred to be false.
+    // The model does not tell which child is best, so the hint is made
+    // independent of hash set order by preferring the child with the lowest variable.
+    int preferredOpVar = 0;
+    for (const auto& [parent, children] : newPos.getExpansions()) {
+        if (!heldAbove(above.getVariableOrZero(VarType::OP, parent))) continue;
+        for (const USignature& child : children) {
+            int childVar = newPos.getVariableOrZero(VarType::OP, child);
+            if (childVar != 0 && (preferredOpVar == 0 || childVar < preferredOpVar)) 
+                preferredOpVar = childVar;
+        }
+        // At most one operation held at the above position
+        break;
+    }
+    int primVar = _vars.getVarPrimitiveOrZero(newPos.getLayerIndex(), newPos.getPositionIndex());
+    for (const auto& [opSig, opVar] : newPos.getVariableTable(VarType::OP)) {
+        if (opVar == primVar) continue;
+        _sat.setPhase(opVar, opVar == preferredOpVar);
+    }
+
+    // New fact variables take the value of the fact at the above position
+    for (const auto& [factSig, factVar] : newPos.getVariableTable(VarType::FACT)) {
+        if (!_new_fact_vars.count(factVar)) continue;
+        int aboveVar = above.getVariableOrZero(VarType::FACT, factSig);
+        if (aboveVar != 0) _sat.setPhase(factVar, heldAbove(aboveVar));
+    }
+}
+
 int Encoding::encodeQConstEquality(int q1, int q2) {
 
     if (!_vars.isQConstantEqualityEncoded(q1, q2)) {
@@ -794,15 +941,7 @@ int Encoding::encodeQConstEquality(int q1, int q2) {
 
 void Encoding::addAssumptions(int layerIdx, bool permanent) {
     Layer& l = *_layers.at(layerIdx);
-    if (_implicit_primitiveness) {
-        _stats.begin(STAGE_ACTIONCONSTRAINTS);
-        for (size_t pos = 0; pos < l.size(); pos++) {
-            _sat.appendClause(-_vars.encodeVarPrimitive(layerIdx, pos));
-            for (int var : _primitive_ops) _sat.appendClause(var);
-            _sat.endClause();
-        }
-        _stats.end(STAGE_ACTIONCONSTRAINTS);
-    }
+    encodePrimitiveness(layerIdx);
     for (size_t pos = 0; pos < l.size(); pos++) {
         _stats.begin(STAGE_ASSUMPTIONS);
         int v = _vars.getVarPrimitiveOrZero(layerIdx, pos);
@@ -814,6 +953,34 @@ void Encoding::addAssumptions(int layerIdx, bool permanent) {
     }
 }
 
+void Encoding::encodePrimitiveness(int layerIdx) {
+    if (!_implicit_primitiveness) return;
+    Layer& l = *_layers.at(layerIdx);
+    _stats.begin(STAGE_ACTIONCONSTRAINTS);
+    for (size_t pos = 0; pos < l.size(); pos++) {
+        _sat.appendClause(-_vars.encodeVarPrimitive(layerIdx, pos));
+        for (int var : _primitive_ops) _sat.appendClause(var);
+        _sat.endClause();
+    }
+    _stats.end(STAGE_ACTIONCONSTRAINTS);
+}
+
+void Encoding::assumePrimitiveness(int layerIdx) {
+    _stats.begin(STAGE_ASSUMPTIONS);
+    for (int v : getPrimitivenessLiterals(layerIdx)) _sat.assume(v);
+    _stats.end(STAGE_ASSUMPTIONS);
+}
+
+std::vector<int> Encoding::getPrimitivenessLiterals(int layerIdx) {
+    Layer& l = *_layers.at(layerIdx);
+    std::vector<int> lits;
+    for (size_t pos = 0; pos < l.size(); pos++) {
+        int v = _vars.getVarPrimitiveOrZero(layerIdx, pos);
+        if (v != 0) lits.push_back(v);
+    }
+    return lits;
+}
+
 void Encoding::setTerminateCallback(void * state, int (*terminate)(void * state)) {
     _sat.setTerminateCallback(state, terminate);
 }
@@ -832,8 +999,27 @@ int Encoding::solve() {
         _sat.setLearnCallback(/*maxLength=*/100, this, onClauseLearnt);
 
     _sat_call_start_time = Timer::elapsedSeconds();
-    int result = _sat.solve();
+    int result;
+    {
+        TRACE_SCOPE("solving");
+        result = _sat.solve();
+
+        // Refine the formula with the deferred frame axioms which the model violates
+        // until the model satisfies all of them
+        size_t numAdded;
+        while (result == 10 && (numAdded = addViolatedFrameAxioms()) > 0) {
+            _num_frame_axiom_refinements++;
+            Log::i("Model violates %i deferred frame axioms (%i remaining) - solving again\n", 
+                    numAdded, _num_deferred_frame_axioms);
+            _sat.reassumeLastAssumptions();
+            result = _sat.solve();
+        }
+    }
+    _last_result = result;
+    float satTime = Timer::elapsedSeconds() - _sat_call_start_time;
     _sat_call_start_time = 0;
+    _last_sat_call_time = satTime;
+    if (_solve_callback) _solve_callback(result, satTime);
 
     _termination_callback();
 
@@ -851,6 +1037,13 @@ float Encoding::getTimeSinceSatCallStart() {
     return Timer::elapsedSeconds() - _sat_call_start_time;
 }
 
+void Encoding::recordPhaseHints(int layerIdx) {
+    _hint_model.assign(_vars.getNumVariables()+1, false);
+    for (int var = 1; var < (int)_hint_model.size(); var++) _hint_model[var] = _sat.holds(var);
+    _hint_layer_idx = layerIdx;
+    Log::v("Recorded phase hints from a model of layer %i\n", layerIdx);
+}
+
 void Encoding::printFailedVars(Layer& layer) {
     Log::d("FAILED ");
     for (size_t pos = 0; pos < layer.size(); pos++) {
@@ -861,6 +1054,29 @@ void Encoding::printFailedVars(Layer& layer) {
     Log::d("\n");
 }
 
+size_t Encoding::deferExpansionsOutsideCore(Layer& layer) {
+
+    // Only an unsatisfiable call provides failed assumptions
+    if (_last_result != 20) return layer.size();
+
+    size_t numCorePositions = 0;
+    std::vector<size_t> deferrablePositions;
+    for (size_t pos = 0; pos < layer.size(); pos++) {
+        int v = _vars.getVarPrimitiveOrZero(layer.index(), pos);
+        if (v == 0) continue; // no reductions to expand
+        if (!layer[pos].hasPrimitiveOps() || _sat.didAssumptionFail(v)) {
+            // Position cannot be primitive or is involved in the unsatisfiability
+            numCorePositions++;
+        } else deferrablePositions.push_back(pos);
+    }
+    // No core: the formula is unsatisfiable without assumptions
+    if (numCorePositions == 0) return layer.size();
+
+    for (size_t pos : deferrablePositions) layer.deferExpansion(pos);
+    layer.consolidate();
+    return layer.size() - deferrablePositions.size();
+}
+
 void Encoding::printSatisfyingAssignment() {
     Log::d("SOLUTION_VALS ");
     for (int v = 1; v <= _vars.getNumVariables(); v++) {
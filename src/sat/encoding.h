@@ -12,6 +12,8 @@
 #include "algo/fact_analysis.h"
 #include "sat/variable_provider.h"
 #include "sat/decoder.h"
+#include "sat/at_most_one.h"
+#include "util/trace.h"
 
 typedef NodeHashMap<int, SigSet> State;
 
@@ -26,8 +28,10 @@ private:
     SatInterface _sat;
     VariableProvider _vars;
     Decoder _decoder;
+    AtMostOne _amo;
 
     std::function<void()> _termination_callback;
+    std::function<void(int, float)> _solve_callback;
     
     size_t _layer_idx;
     size_t _pos;
@@ -46,38 +50,101 @@ private:
     const bool _use_q_constant_mutexes;
     const bool _implicit_primitiveness;
 
+    // Model of the last layer (solved without assumptions)
+    // to set the phases of the next layer's variables
+    const bool _phase_hints;
+    std::vector<bool> _hint_model;
+    int _hint_layer_idx = -1;
+
+    // Frame axioms of facts which no operation at their position has as a precondition
+    // are withheld from the solver and only added once a model violates them.
+    // The deferred frame axioms of a fact between two of its eagerly encoded ones
+    // form a run (of zero-terminated clauses) which is added as a whole.
+    const bool _lazy_frame_axioms;
+    std::vector<std::vector<int>> _deferred_runs;
+    FlatHashMap<USignature, size_t, USignatureHasher> _open_deferred_runs;
+    int _deferred_runs_layer = -1;
+    size_t _num_deferred_frame_axioms = 0;
+    size_t _num_deferred_frame_axioms_total = 0;
+    size_t _num_frame_axiom_refinements = 0;
+    USigSet _precondition_facts;
+
     float _sat_call_start_time;
+    float _last_sat_call_time = 0;
+    int _last_result = 0;
 
 public:
     Encoding(Parameters& params, HtnInstance& htn, FactAnalysis& analysis, std::vector<Layer*>& layers, std::function<void()> terminationCallback) : 
             _params(params), _htn(htn), _analysis(analysis), _layers(layers),
             _sat(params, _stats), _vars(_params, _htn, _layers),
             _decoder(_htn, _layers, _sat, _vars),
+            _amo(params, ipasir_signature()),
             _termination_callback(terminationCallback),
             _use_q_constant_mutexes(_params.getIntParam("qcm") > 0), 
-            _implicit_primitiveness(params.isNonzero("ip")) {}
+            _implicit_primitiveness(params.isNonzero("ip")),
+            _phase_hints(params.isNonzero("svp") && SatInterface::supportsPhases()),
+            _lazy_frame_axioms(params.isNonzero("lfa")) {
+
+        if (params.isNonzero("svp") && !_phase_hints) 
+            Log::w("Solver %s does not support phases - ignoring -svp\n", ipasir_signature());
+        
+        std::string profileFile = _params.getParam("spf", "");
+        if (!profileFile.empty()) _stats.openProfile(profileFile);
+    }
 
     void encode(size_t layerIdx, size_t pos);
     void addAssumptions(int layerIdx, bool permanent = false);
+    // Only encodes the primitiveness variables of all positions of the given layer (if implicit)
+    void encodePrimitiveness(int layerIdx);
+    // Only (re-)assumes the primitiveness of all positions of the given layer
+    void assumePrimitiveness(int layerIdx);
+    std::vector<int> getPrimitivenessLiterals(int layerIdx);
     void addUnitConstraint(int lit);
+    // Lets the solver eliminate the operation variables of a position 
+    // whose successors and children have all been encoded
+    void meltOperationVariables(const Position& pos) {
+        // Deferred frame axioms may still refer to them
+        if (_lazy_frame_axioms) return;
+        pos.forEachVariable(VarType::OP, [&](const USignature&, int var) {_sat.melt(var);});
+    }
     
     void setTerminateCallback(void * state, int (*terminate)(void * state));
+    // Called after each SAT call with its result and duration
+    void setSolveCallback(std::function<void(int, float)> callback) {_solve_callback = callback;}
     int solve();
     float getTimeSinceSatCallStart();    
+    float getLastSatCallTime() const {return _last_sat_call_time;}
+
+    bool usesPhaseHints() const {return _phase_hints;}
+    // Remembers the current model of the given layer as a guide for encoding the next layer
+    void recordPhaseHints(int layerIdx);
+
+    // Adds all deferred frame axioms to the formula, e.g., before it is copied
+    void addDeferredFrameAxioms();
+    size_t getNumDeferredFrameAxioms() const {return _num_deferred_frame_axioms_total;}
+    size_t getNumFrameAxiomRefinements() const {return _num_frame_axiom_refinements;}
 
     void printFailedVars(Layer& layer);
+    // After an unsatisfiable call, defers the expansion of all positions of the layer
+    // whose primitiveness is not part of the failed assumptions; returns the number
+    // of positions which are still expanded
+    size_t deferExpansionsOutsideCore(Layer& layer);
     void printSatisfyingAssignment();
 
     Plan extractPlan() {
+        TRACE_SCOPE("decoding");
         return _decoder.extractPlan();
     }
     void printStatistics() {
         _stats.printStages();
     }
     SatInterface& getSatInterface() {return _sat;}
+    Parameters& getParameters() {return _params;}
     EncodingStatistics& getEncodingStatistics() {return _stats;}
 
     ~Encoding() {
+        // Written formula must be complete
+        if (_params.isNonzero("wf")) addDeferredFrameAxioms();
         // Append assumptions to written formula, close stream
         if (!_params.isNonzero("cs") && !_sat.hasLastAssumptions()) {
             addAssumptions(_layers.size()-1);
@@ -88,13 +155,19 @@ private:
     void encodeOperationVariables(Position& pos);
     void encodeFactVariables(Position& pos, Position& left, Position& above);
     void encodeFrameAxioms(Position& pos, Position& left);
-    void encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int opVar, const IntPairTree& tree);
+    void encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int opVar, const IntPairTree& tree, 
+            std::vector<int>* deferTo);
+    void collectPreconditionFacts(Position& pos);
+    size_t addViolatedFrameAxioms();
+    size_t addDeferredRun(std::vector<int>& run);
     void encodeOperationConstraints(Position& pos);
     void encodeSubstitutionVars(const USignature& opSig, int opVar, int qconst);
+    void encodeAtMostOne(const std::vector<int>& vars);
     void encodeQFactSemantics(Position& pos);
     void encodeActionEffects(Position& pos, Position& left);
     void encodeQConstraints(Position& pos);
     void encodeSubtaskRelationships(Position& pos, Position& above);
+    void encodePhaseHints(Position& pos, Position& above);
     int encodeQConstEquality(int q1, int q2);
 };
 
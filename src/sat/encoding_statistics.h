@@ -4,9 +4,14 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <fstream>
 #include <assert.h>
 
 #include "util/log.h"
+#include "util/timer.h"
+#include "util/memusage.h"
+#include "sat/variable_domain.h"
 
 const int STAGE_ACTIONCONSTRAINTS = 0;
 const int STAGE_ACTIONEFFECTS = 1;
@@ -29,6 +34,7 @@ const int STAGE_SUBSTITUTIONCONSTRAINTS = 17;
 const int STAGE_TRUEFACTS = 18;
 const int STAGE_ASSUMPTIONS = 19;
 const int STAGE_PLANLENGTHCOUNTING = 20;
+const int STAGE_INSTANTIATION = 21;
 
 class EncodingStatistics {
 
@@ -38,63 +44,235 @@ public:
     int _num_asmpts = 0;
     int _prev_num_cls = 0;
     int _prev_num_lits = 0;
+    // Number of variables excluded from branching, per role
+    std::vector<int> _num_non_decision_vars = std::vector<int>(NUM_VAR_ROLES, 0);
+    // Number of variables handed to the solver as frozen resp. melted again
+    int _num_frozen_vars = 0;
+    int _num_melted_vars = 0;
 
 private:
-    const char* STAGES_NAMES[21] = {"actionconstraints","actioneffects","atleastoneelement","atmostoneelement",
+    const char* STAGES_NAMES[22] = {"actionconstraints","actioneffects","atleastoneelement","atmostoneelement",
         "axiomaticops","directframeaxioms","expansions","factpropagation","factvarencoding","forbiddenoperations",
         "indirectframeaxioms", "initsubstitutions","predecessors","qconstequality","qfactsemantics",
-        "qtypeconstraints","reductionconstraints","substitutionconstraints","truefacts","assumptions","planlengthcounting"};
-    std::vector<int> _num_cls_per_stage;
+        "qtypeconstraints","reductionconstraints","substitutionconstraints","truefacts","assumptions","planlengthcounting",
+        "instantiation"};
+
+    struct Counters {
+        double time = 0;
+        int cls = 0;
+        int lits = 0;
+        int vars = 0;
+        double rssKb = 0;
+
+        void add(const Counters& other) {
+            time += other.time; cls += other.cls; lits += other.lits; vars += other.vars; rssKb += other.rssKb;
+        }
+        bool empty() const {
+            return cls == 0 && lits == 0 && vars == 0 && time == 0;
+        }
+    };
+
+    std::vector<Counters> _stage_totals;
+    std::vector<Counters> _position_stages;
+    std::vector<Counters> _layer_totals;
+    std::vector<std::map<std::string, int>> _amo_encodings_per_stage;
     std::vector<int> _current_stages;
-    int _num_cls_at_stage_start = 0;
+    Counters _stage_start;
+
+    int _layer_idx = -1;
+    int _pos = -1;
+    bool _in_position = false;
+    bool _position_encoded = false;
+    double _position_start_rss = 0;
+    double _layer_start_rss = 0;
+
+    std::ofstream _profile_out;
 
 public:
     EncodingStatistics() {
-        _num_cls_per_stage.resize(sizeof(STAGES_NAMES)/sizeof(*STAGES_NAMES));
+        size_t numStages = sizeof(STAGES_NAMES)/sizeof(*STAGES_NAMES);
+        _stage_totals.resize(numStages);
+        _position_stages.resize(numStages);
+        _amo_encodings_per_stage.resize(numStages);
     }
 
-    void beginPosition() {
+    // Write a CSV line for each stage of each position to the given file
+    void openProfile(const std::string& filename) {
+        _profile_out.open(filename);
+        _profile_out << "layer,pos,stage,seconds,clauses,literals,variables,rss_delta_kb\n";
+    }
+
+    void beginPosition(int layerIdx = -1, int pos = -1) {
         _prev_num_cls = _num_cls;
         _prev_num_lits = _num_lits;
+        _in_position = true;
+        _position_encoded = false;
+        if (layerIdx >= 0 && layerIdx != _layer_idx) beginLayer(layerIdx);
+        _layer_idx = layerIdx;
+        _pos = pos;
+        if (_profile_out.is_open()) _position_start_rss = getResidentSetKb();
     }
 
     void endPosition() {
         assert(_current_stages.empty());
-        Log::v("  Encoded %i cls, %i lits\n", _num_cls-_prev_num_cls, _num_lits-_prev_num_lits);
+        _in_position = false;
+        if (_position_encoded)
+            Log::v("  Encoded %i cls, %i lits\n", _num_cls-_prev_num_cls, _num_lits-_prev_num_lits);
+
+        Counters sum = flushPositionStages();
+        if (_profile_out.is_open()) {
+            sum.rssKb = getResidentSetKb() - _position_start_rss;
+            writeProfileLine("position", sum);
+        }
+    }
+
+    // A position is instantiated one layer phase before it is encoded:
+    // its instantiation gets its own profile row, but no "position" row
+    void beginInstantiation(int layerIdx, int pos) {
+        if (layerIdx != _layer_idx) beginLayer(layerIdx);
+        _pos = pos;
+        _in_position = true;
+        begin(STAGE_INSTANTIATION);
+    }
+
+    void endInstantiation() {
+        end(STAGE_INSTANTIATION);
+        assert(_current_stages.empty());
+        _in_position = false;
+        flushPositionStages();
     }
 
     void begin(int stage) {
         if (!_current_stages.empty()) {
             int oldStage = _current_stages.back();
-            _num_cls_per_stage[oldStage] += _num_cls - _num_cls_at_stage_start;
+            account(oldStage);
+        } else {
+            _stage_start = snapshot();
         }
-        _num_cls_at_stage_start = _num_cls;
+        if (stage != STAGE_INSTANTIATION) _position_encoded = true;
         _current_stages.push_back(stage);
     }
 
     void end(int stage) {
         assert(!_current_stages.empty() && _current_stages.back() == stage);
         _current_stages.pop_back();
-        _num_cls_per_stage[stage] += _num_cls - _num_cls_at_stage_start;
-        _num_cls_at_stage_start = _num_cls;
+        account(stage);
+    }
+
+    // Record that an at-most-one constraint with the given encoding was added in the current stage
+    void addAtMostOne(const char* encoding) {
+        if (_current_stages.empty() || _amo_encodings_per_stage.empty()) return;
+        _amo_encodings_per_stage[_current_stages.back()][encoding]++;
     }
 
     void printStages() {
         Log::i("Total amount of clauses encoded: %i\n", _num_cls);
-        std::map<int, int, std::greater<int>> stagesSorted;
-        for (size_t stage = 0; stage < _num_cls_per_stage.size(); stage++) {
-            if (_num_cls_per_stage[stage] > 0)
-                stagesSorted[_num_cls_per_stage[stage]] = stage;
+        std::multimap<int, int, std::greater<int>> stagesSorted;
+        for (size_t stage = 0; stage < _stage_totals.size(); stage++) {
+            if (!_stage_totals[stage].empty())
+                stagesSorted.emplace(_stage_totals[stage].cls, stage);
         }
         for (const auto& [num, stage] : stagesSorted) {
-            Log::i("- %s : %i cls\n", STAGES_NAMES[stage], num);
+            const Counters& c = _stage_totals[stage];
+            Log::i("- %s : %i cls, %i lits, %i vars, %.4fs\n", STAGES_NAMES[stage], num, c.lits, c.vars, c.time);
+            for (const auto& [encoding, count] : _amo_encodings_per_stage[stage]) {
+                Log::i("  - at-most-one %s : %i\n", encoding.c_str(), count);
+            }
+        }
+        int numNonDecisionVars = 0;
+        for (int num : _num_non_decision_vars) numNonDecisionVars += num;
+        if (numNonDecisionVars > 0) {
+            int numVars = VariableDomain::getMaxVar();
+            Log::i("Non-decision variables: %i of %i (%.2f%%)\n", numNonDecisionVars, numVars, 100.0 * numNonDecisionVars / numVars);
+            for (int role = 0; role < NUM_VAR_ROLES; role++) if (_num_non_decision_vars[role] > 0) {
+                Log::i("- %s : %i\n", VariableDomain::getRoleName((VarRole) role), _num_non_decision_vars[role]);
+            }
         }
-        _num_cls_per_stage.clear();
+        if (_num_frozen_vars > 0) {
+            Log::i("Frozen variables: %i, melted again: %i\n", _num_frozen_vars, _num_melted_vars);
+        }
+        if (_layer_idx >= 0 && (size_t)_layer_idx < _layer_totals.size()) {
+            _layer_totals[_layer_idx].rssKb += getResidentSetKb() - _layer_start_rss;
+            _layer_start_rss = getResidentSetKb();
+        }
+        for (size_t layer = 0; layer < _layer_totals.size(); layer++) {
+            const Counters& c = _layer_totals[layer];
+            Log::i("- layer %i : %i cls, %i lits, %i vars, %.4fs, %+.0f kB rss\n",
+                    layer, c.cls, c.lits, c.vars, c.time, c.rssKb);
+        }
+        _stage_totals.clear();
+        _layer_totals.clear();
+        _amo_encodings_per_stage.clear();
+        _layer_idx = -1;
     }
 
     ~EncodingStatistics() {
         printStages();
     }
+
+private:
+    Counters snapshot() const {
+        Counters c;
+        c.time = Timer::now();
+        c.cls = _num_cls;
+        c.lits = _num_lits;
+        c.vars = VariableDomain::getMaxVar();
+        return c;
+    }
+
+    void account(int stage) {
+        Counters now = snapshot();
+        Counters delta;
+        delta.time = now.time - _stage_start.time;
+        delta.cls = now.cls - _stage_start.cls;
+        delta.lits = now.lits - _stage_start.lits;
+        delta.vars = now.vars - _stage_start.vars;
+        if ((size_t)stage < _stage_totals.size()) _stage_totals[stage].add(delta);
+        if (_in_position) _position_stages[stage].add(delta);
+        _stage_start = now;
+    }
+
+    void beginLayer(int layerIdx) {
+        // Attribute the memory growth since the last layer change to the previous layer
+        double rss = getResidentSetKb();
+        if (_layer_idx >= 0) {
+            if ((size_t)_layer_idx >= _layer_totals.size()) _layer_totals.resize(_layer_idx+1);
+            _layer_totals[_layer_idx].rssKb += rss - _layer_start_rss;
+        }
+        _layer_start_rss = rss;
+        _layer_idx = layerIdx;
+    }
+
+    // Writes the stages of the current position to the profile 
+    // and adds them to the layer's totals; returns their sum
+    Counters flushPositionStages() {
+        Counters sum;
+        for (size_t stage = 0; stage < _position_stages.size(); stage++) {
+            const Counters& c = _position_stages[stage];
+            if (c.empty()) continue;
+            sum.add(c);
+            if (_profile_out.is_open()) writeProfileLine(STAGES_NAMES[stage], c);
+            _position_stages[stage] = Counters();
+        }
+        if (_layer_idx >= 0) {
+            if ((size_t)_layer_idx >= _layer_totals.size()) _layer_totals.resize(_layer_idx+1);
+            Counters layerSum = sum;
+            layerSum.rssKb = 0; // accounted for at layer granularity
+            _layer_totals[_layer_idx].add(layerSum);
+        }
+        return sum;
+    }
+
+    void writeProfileLine(const char* stage, const Counters& c) {
+        _profile_out << _layer_idx << "," << _pos << "," << stage << "," << c.time << ","
+                << c.cls << "," << c.lits << "," << c.vars << "," << c.rssKb << "\n";
+    }
+
+    static double getResidentSetKb() {
+        double vm, rss;
+        process_mem_usage(vm, rss);
+        return rss;
+    }
 };
 
 #endif
@@ -125,5 +125,10 @@ void ipasir_set_phase (void * s, unsigned int v, bool phase);
  * Set the given variable to be a decision variable or not.
  */
 void ipasir_set_decision_var (void * s, unsigned int v, bool decision_var);
+/**
+ * Set the given variable to be frozen (it may occur in future clauses or assumptions
+ * and must not be eliminated) or melted again. Calls must be balanced. May be ignored.
+ */
+void ipasir_set_frozen (void * s, unsigned int v, bool frozen);
 
 #endif
@@ -0,0 +1,15 @@
+
+#include <algorithm>
+
+#include "sat/op_variable_index.h"
+
+bool OpVariableIndex::find(int var, int& layer, int& pos, USignature& sig) const {
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), var, [](const Entry& e, int v) {
+        return e.var < v;
+    });
+    if (it == _entries.end() || it->var != var) return false;
+    layer = it->layer;
+    pos = it->pos;
+    sig = getSignature(it - _entries.begin());
+    return true;
+}
@@ -0,0 +1,57 @@
+
+#ifndef DOMPASCH_LILOTANE_OP_VARIABLE_INDEX_H
+#define DOMPASCH_LILOTANE_OP_VARIABLE_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <assert.h>
+
+#include "data/signature.h"
+
+/*
+Compact reverse index from operation variables to the layer, position and signature
+they were introduced for. Variables must be added in increasing order, which is the
+order in which VariableDomain hands them out.
+*/
+class OpVariableIndex {
+
+private:
+    struct Entry {
+        int var;
+        int layer;
+        int pos;
+        int nameId;
+        uint32_t argsBegin;
+    };
+    std::vector<Entry> _entries;
+    std::vector<int> _args;
+
+public:
+    void add(int var, int layer, int pos, const USignature& sig) {
+        assert(_entries.empty() || _entries.back().var < var);
+        _entries.push_back(Entry{var, layer, pos, sig._name_id, (uint32_t)_args.size()});
+        _args.insert(_args.end(), sig._args.begin(), sig._args.end());
+    }
+
+    size_t size() const {return _entries.size();}
+
+    // Calls f(var, layer, pos, sig) for each indexed variable with pred(var) == true
+    template <typename P, typename F>
+    void forEachIf(P pred, F f) const {
+        for (size_t i = 0; i < _entries.size(); i++) {
+            const Entry& e = _entries[i];
+            if (pred(e.var)) f(e.var, e.layer, e.pos, getSignature(i));
+        }
+    }
+
+    // Looks up the given variable; returns false if it is not an indexed operation variable
+    bool find(int var, int& layer, int& pos, USignature& sig) const;
+
+private:
+    USignature getSignature(size_t idx) const {
+        uint32_t end = idx+1 < _entries.size() ? _entries[idx+1].argsBegin : _args.size();
+        return USignature(_entries[idx].nameId, std::vector<int>(_args.begin()+_entries[idx].argsBegin, _args.begin()+end));
+    }
+};
+
+#endif
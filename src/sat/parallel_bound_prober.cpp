@@ -0,0 +1,111 @@
+
+#include <chrono>
+#include <assert.h>
+
+#include "sat/parallel_bound_prober.h"
+
+extern "C" {
+    #include "sat/ipasir.h"
+}
+
+int terminateProbe(void* state) {
+    auto* solver = (ParallelBoundProber::Solver*) state;
+    return solver->cancelled || solver->prober->_stopped ? 1 : 0;
+}
+
+ParallelBoundProber::ParallelBoundProber(const std::vector<int>& formula, int numVars, int numSolvers, int seed) :
+        _formula(formula), _num_vars(numVars) {
+
+    for (int i = 0; i < numSolvers; i++) {
+        _solvers.emplace_back();
+        Solver& solver = _solvers.back();
+        solver.prober = this;
+        solver.index = i;
+        _solver_ptrs.push_back(&solver);
+    }
+    for (Solver* solver : _solver_ptrs) {
+        solver->thread = std::thread([this, solver, seed]() {run(*solver, seed+1+solver->index);});
+    }
+}
+
+void ParallelBoundProber::run(Solver& solver, int seed) {
+
+    void* sat = ipasir_init();
+    ipasir_set_seed(sat, seed);
+    ipasir_set_terminate(sat, &solver, terminateProbe);
+
+    // Replay the formula
+    for (int lit : _formula) {
+        if (_stopped) break;
+        ipasir_add(sat, lit);
+    }
+
+    while (true) {
+        int bound;
+        std::vector<int> assumptions;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _task_cond.wait(lock, [&]() {return _stopped || solver.hasTask;});
+            if (_stopped) break;
+            bound = solver.bound;
+            assumptions = std::move(solver.assumptions);
+        }
+
+        for (int lit : assumptions) ipasir_assume(sat, lit);
+        Result result{solver.index, bound, ipasir_solve(sat), std::vector<bool>()};
+        if (result.result == 10) {
+            result.model.resize(_num_vars+1);
+            for (int v = 1; v <= _num_vars; v++) result.model[v] = ipasir_val(sat, v) > 0;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            solver.hasTask = false;
+            _results.push_back(std::move(result));
+        }
+        _result_cond.notify_all();
+    }
+
+    ipasir_release(sat);
+}
+
+void ParallelBoundProber::probe(int solverIdx, int bound, std::vector<int>&& assumptions) {
+    Solver& solver = *_solver_ptrs[solverIdx];
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        assert(!solver.hasTask);
+        solver.cancelled = false;
+        solver.bound = bound;
+        solver.assumptions = std::move(assumptions);
+        solver.hasTask = true;
+    }
+    _task_cond.notify_all();
+}
+
+void ParallelBoundProber::cancel(int solverIdx) {
+    _solver_ptrs[solverIdx]->cancelled = true;
+}
+
+bool ParallelBoundProber::waitForResult(float seconds, Result& result) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool found = _result_cond.wait_for(lock, std::chrono::duration<float>(seconds),
+        [&]() {return !_results.empty();});
+    if (!found) return false;
+    result = std::move(_results.front());
+    _results.erase(_results.begin());
+    return true;
+}
+
+void ParallelBoundProber::stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stopped) return;
+        _stopped = true;
+    }
+    _task_cond.notify_all();
+    for (Solver* solver : _solver_ptrs) solver->thread.join();
+}
+
+ParallelBoundProber::~ParallelBoundProber() {
+    stop();
+}
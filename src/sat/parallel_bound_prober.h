@@ -0,0 +1,74 @@
+
+#ifndef DOMPASCH_LILOTANE_PARALLEL_BOUND_PROBER_H
+#define DOMPASCH_LILOTANE_PARALLEL_BOUND_PROBER_H
+
+#include <vector>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+A pool of SAT solver instances, each running in its own thread, which are initialized
+with a copy of a recorded formula and then probe different bounds concurrently
+(each probe being a set of assumptions). Probes can be cancelled individually.
+*/
+class ParallelBoundProber {
+
+public:
+    struct Result {
+        int solver;
+        int bound;
+        // 10: SAT, 20: UNSAT, 0: interrupted
+        int result;
+        // Truth value of each variable if SAT
+        std::vector<bool> model;
+    };
+
+private:
+    struct Solver {
+        ParallelBoundProber* prober;
+        int index;
+        std::thread thread;
+        std::atomic_bool cancelled {false};
+        bool hasTask = false;
+        int bound;
+        std::vector<int> assumptions;
+    };
+
+    const std::vector<int>& _formula;
+    int _num_vars;
+    std::list<Solver> _solvers;
+    std::vector<Solver*> _solver_ptrs;
+
+    std::mutex _mutex;
+    std::condition_variable _task_cond;
+    std::condition_variable _result_cond;
+    std::vector<Result> _results;
+    std::atomic_bool _stopped {false};
+
+public:
+    // The formula is a sequence of zero-terminated clauses and must outlive the prober.
+    ParallelBoundProber(const std::vector<int>& formula, int numVars, int numSolvers, int seed);
+    ~ParallelBoundProber();
+
+    size_t size() const {return _solver_ptrs.size();}
+
+    // Lets the given (idle) solver search for a model under the given assumptions.
+    void probe(int solver, int bound, std::vector<int>&& assumptions);
+    // Interrupts the current probe of the given solver. Its result is still reported.
+    void cancel(int solver);
+
+    // Waits at most the given time for the result of some probe.
+    bool waitForResult(float seconds, Result& result);
+
+    // Interrupts all probes and releases all solvers.
+    void stop();
+
+private:
+    void run(Solver& solver, int seed);
+    friend int terminateProbe(void* state);
+};
+
+#endif
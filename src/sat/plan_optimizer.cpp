@@ -1,8 +1,15 @@
 
+#include <algorithm>
+
 #include "sat/plan_optimizer.h"
 
 void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition mode) {
 
+    if (_engine != OPT_COUNTER_LINEAR) {
+        optimizePlanWithTotalizer(upperBound, plan, mode);
+        return;
+    }
+
     int layerIdx = _layers.size()-1;
     Layer& l = *_layers.at(layerIdx);
     int currentPlanLength = upperBound;
@@ -12,7 +19,7 @@ void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition
     _stats.begin(STAGE_PLANLENGTHCOUNTING);
     int minPlanLength = 0;
     int maxPlanLength = 0;
-    std::vector<int> planLengthVars(1, VariableDomain::nextVar());
+    std::vector<int> planLengthVars(1, VariableDomain::nextVar(ROLE_COUNTER));
     Log::d("VARNAME %i (plan_length_equals %i %i)\n", planLengthVars[0], 0, 0);
     // At position zero, the plan length is always equal to zero
     _sat.addClause(planLengthVars[0]);
@@ -20,22 +27,7 @@ void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition
 
         // Collect sets of potential operations
         FlatHashSet<int> emptyActions, actualActions;
-        for (const auto& aSig : l.at(pos).getActions()) {
-            Log::d("PLO %i %s?\n", pos, TOSTR(aSig));
-            int aVar = l.at(pos).getVariable(VarType::OP, aSig);
-            if (isEmptyAction(aSig)) {
-                emptyActions.insert(aVar);
-            } else {
-                actualActions.insert(aVar);
-            }
-        }
-        for (const auto& rSig : l.at(pos).getReductions()) {
-            Log::d("PLO %i %s?\n", pos, TOSTR(rSig));
-            if (_htn.getOpTable().getReduction(rSig).getSubtasks().size() == 0) {
-                // Empty reduction
-                emptyActions.insert(l.at(pos).getVariable(VarType::OP, rSig));
-            }
-        }
+        collectOperations(l, pos, emptyActions, actualActions);
 
         if (emptyActions.empty()) {
             // Only actual actions here: Increment lower and upper bound, keep all variables.
@@ -63,7 +55,7 @@ void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition
             bool encodeActualsOnly = emptyActions.size() > actualActions.size();
             if (!encodeDirectly) {
                 // Encode with a helper variable
-                emptySpotVar = VariableDomain::nextVar();
+                emptySpotVar = VariableDomain::nextVar(ROLE_COUNTER);
 
                 // Define for each action var whether it implies an empty spot or not
                 for (int v : emptyActions) {
@@ -79,7 +71,7 @@ void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition
             // create new variables and constraints.
             std::vector<int> newPlanLengthVars(planLengthVars.size()+(increaseUpperBound?1:0));
             for (size_t i = 0; i < newPlanLengthVars.size(); i++) {
-                newPlanLengthVars[i] = VariableDomain::nextVar();
+                newPlanLengthVars[i] = VariableDomain::nextVar(ROLE_COUNTER);
             }
 
             // Propagate plan length from previous position to new position
@@ -152,26 +144,46 @@ void PlanOptimizer::optimizePlan(int upperBound, Plan& plan, ConstraintAddition
     assert((int)planLengthVars.size() == maxPlanLength-minPlanLength+1 || Log::e("%i != %i-%i+1\n", planLengthVars.size(), maxPlanLength, minPlanLength));
     
     // Add primitiveness of all positions at the final layer
-    // as unit literals (instead of assumptions)
-    _enc.addAssumptions(layerIdx, /*permanent=*/mode == ConstraintAddition::PERMANENT);
+    // (as unit literals in permanent mode)
+    addPrimitiveness(layerIdx, mode, /*probing=*/_num_probing_solvers > 1);
     _stats.end(STAGE_PLANLENGTHCOUNTING);
 
-    int curr = currentPlanLength;
-    currentPlanLength = findMinBySat(minPlanLength, std::min(maxPlanLength, currentPlanLength), 
-        // Variable mapping
-        [&](int currentMax) {
-            return planLengthVars[currentMax-minPlanLength];
-        }, 
-        // Bound update on SAT 
-        [&]() {
-            // SAT: Shorter plan found!
-            plan = _enc.extractPlan();
-            int newPlanLength = getPlanLength(std::get<0>(plan));
-            Log::i("Shorter plan (length %i) found\n", newPlanLength);
-            assert(newPlanLength < curr);
-            curr = newPlanLength;
-            return newPlanLength;
-        }, mode);
+    if (_num_probing_solvers > 1) {
+        int lower = minPlanLength;
+        int upper = std::min(maxPlanLength, currentPlanLength);
+        auto boundLiterals = [&](int bound) {
+            // Forbid all plan lengths greater than the bound
+            std::vector<int> lits;
+            for (int x = bound+1; x <= maxPlanLength; x++) lits.push_back(-planLengthVars[x-minPlanLength]);
+            return lits;
+        };
+        probeInParallel(lower, upper, boundLiterals, plan, mode);
+        currentPlanLength = upper;
+        if (mode == PERMANENT) {
+            // Never fall back behind the best plan
+            _stats.begin(STAGE_PLANLENGTHCOUNTING);
+            for (int lit : boundLiterals(upper)) _sat.addClause(lit);
+            _stats.end(STAGE_PLANLENGTHCOUNTING);
+        }
+    } else {
+        int curr = currentPlanLength;
+        currentPlanLength = findMinBySat(minPlanLength, std::min(maxPlanLength, currentPlanLength), 
+            // Variable mapping
+            [&](int currentMax) {
+                return planLengthVars[currentMax-minPlanLength];
+            }, 
+            // Bound update on SAT 
+            [&]() {
+                // SAT: Shorter plan found!
+                plan = _enc.extractPlan();
+                int newPlanLength = getPlanLength(std::get<0>(plan));
+                Log::i("Shorter plan (length %i) found\n", newPlanLength);
+                assert(newPlanLength < curr);
+                reportImprovedPlan(plan, newPlanLength);
+                curr = newPlanLength;
+                return newPlanLength;
+            }, mode);
+    }
 
     float factor = (float)currentPlanLength / minPlanLength;
     if (factor <= 1) {
@@ -223,7 +235,7 @@ int PlanOptimizer::findMinBySat(int lower, int upper, std::function<int(int)> va
         _stats.end(STAGE_PLANLENGTHCOUNTING);
 
         Log::i("Searching for a plan of length < %i\n", upper);
-        int result = _enc.solve();
+        int result = solve(mode);
 
         // Check result
         if (result == 10) {
@@ -244,6 +256,299 @@ int PlanOptimizer::findMinBySat(int lower, int upper, std::function<int(int)> va
     return current;
 }
 
+void PlanOptimizer::optimizePlanWithTotalizer(int upperBound, Plan& plan, ConstraintAddition mode) {
+
+    int layerIdx = _layers.size()-1;
+    Layer& l = *_layers.at(layerIdx);
+    Log::v("PLO BEGIN %i\n", upperBound);
+
+    // Define an indicator variable for each position which may or may not be empty
+    _stats.begin(STAGE_PLANLENGTHCOUNTING);
+    int minPlanLength = 0;
+    std::vector<int> nonEmptySpotVars;
+    for (size_t pos = 0; pos+1 < l.size(); pos++) {
+        FlatHashSet<int> emptyActions, actualActions;
+        collectOperations(l, pos, emptyActions, actualActions);
+        if (emptyActions.empty()) {
+            minPlanLength++;
+        } else if (!actualActions.empty()) {
+            int spotVar = VariableDomain::nextVar(ROLE_COUNTER);
+            Log::d("VARNAME %i (nonempty_spot %i %i)\n", spotVar, layerIdx, pos);
+            // IF an actual action occurs, THEN the spot is not empty, and vice versa.
+            for (int v : actualActions) _sat.addClause(-v, spotVar);
+            for (int v : emptyActions) _sat.addClause(-v, -spotVar);
+            nonEmptySpotVars.push_back(spotVar);
+        }
+    }
+    int lower = minPlanLength;
+    int upper = std::min(upperBound, minPlanLength + (int)nonEmptySpotVars.size());
+    Log::i("Tightened initial plan length bounds at layer %i: [0,%i] => [%i,%i]\n",
+            layerIdx, l.size()-1, lower, upper);
+
+    addPrimitiveness(layerIdx, mode, /*probing=*/_num_probing_solvers > 1 && _engine != OPT_TOTALIZER_CORES);
+    _stats.end(STAGE_PLANLENGTHCOUNTING);
+
+    if (_engine == OPT_TOTALIZER_CORES) {
+        if (_num_probing_solvers > 1) Log::w("Parallel bound probing is not supported by core-guided optimization\n");
+        raiseLowerBoundByCores(lower, upper, nonEmptySpotVars, plan, mode);
+    } else if (_num_probing_solvers > 1) {
+        // Encode all bounds of interest before the formula is cloned
+        Totalizer tot(nonEmptySpotVars);
+        _stats.begin(STAGE_PLANLENGTHCOUNTING);
+        encodeLengthBound(tot, minPlanLength, upper-1);
+        _stats.end(STAGE_PLANLENGTHCOUNTING);
+        probeInParallel(lower, upper, [&](int bound) {
+            int lit = tot.getAtMostLiteral(bound-minPlanLength);
+            return lit != 0 ? std::vector<int>(1, lit) : std::vector<int>();
+        }, plan, mode);
+        if (mode == PERMANENT) {
+            // Never fall back behind the best plan
+            _stats.begin(STAGE_PLANLENGTHCOUNTING);
+            int lit = encodeLengthBound(tot, minPlanLength, upper);
+            if (lit != 0) _sat.addClause(lit);
+            _stats.end(STAGE_PLANLENGTHCOUNTING);
+        }
+    } else {
+        Totalizer tot(nonEmptySpotVars);
+        searchBounds(lower, upper, tot, minPlanLength, plan, mode);
+    }
+
+    Log::v("PLO END %i\n", upper);
+    if (lower >= upper) {
+        Log::i("Plan length %i is optimal at layer %i\n", upper, layerIdx);
+    } else {
+        Log::i("Plan length %i, lower bound %i at layer %i (gap: %i)\n", upper, lower, layerIdx, upper-lower);
+    }
+}
+
+void PlanOptimizer::searchBounds(int& lower, int& upper, Totalizer& tot, int minPlanLength, Plan& plan, ConstraintAddition mode) {
+
+    int step = 1;
+    while (lower < upper) {
+
+        // Select the bound to probe
+        int probe;
+        if (_engine == OPT_TOTALIZER_BINARY) probe = lower + (upper-1-lower)/2;
+        else if (_engine == OPT_TOTALIZER_GEOMETRIC) probe = std::max(lower, upper-step);
+        else probe = upper-1;
+
+        _stats.begin(STAGE_PLANLENGTHCOUNTING);
+        int lit = encodeLengthBound(tot, minPlanLength, probe);
+        if (lit != 0) _sat.assume(lit);
+        _stats.end(STAGE_PLANLENGTHCOUNTING);
+
+        Log::i("Searching for a plan of length <= %i (bounds: [%i,%i])\n", probe, lower, upper);
+        int result = solve(mode);
+
+        if (result == 10) {
+            // SAT: Shorter plan found!
+            plan = _enc.extractPlan();
+            int newPlanLength = getPlanLength(std::get<0>(plan));
+            Log::i("Shorter plan (length %i) found\n", newPlanLength);
+            assert(newPlanLength <= probe);
+            upper = newPlanLength;
+            reportImprovedPlan(plan, upper);
+            step *= 2;
+            if (mode == PERMANENT) {
+                // Never fall back behind this plan
+                _stats.begin(STAGE_PLANLENGTHCOUNTING);
+                int lit = encodeLengthBound(tot, minPlanLength, upper);
+                if (lit != 0) _sat.addClause(lit);
+                _stats.end(STAGE_PLANLENGTHCOUNTING);
+            }
+            Log::v("PLO UPDATE %i\n", upper);
+        } else if (result == 20) {
+            // UNSAT: Raise lower bound
+            lower = probe+1;
+            step = std::max(1, step/2);
+            Log::i("No plan of length <= %i exists\n", probe);
+        } else {
+            // UNKNOWN
+            break;
+        }
+    }
+}
+
+void PlanOptimizer::raiseLowerBoundByCores(int& lower, int& upper, const std::vector<int>& nonEmptySpotVars, 
+            Plan& plan, ConstraintAddition mode) {
+
+    // Soft literals: each spot is empty, or each totalizer over a former core
+    // does not exceed its current bound. 
+    struct Soft {int lit; int totalizer; int bound;};
+    std::vector<Soft> softs;
+    for (int v : nonEmptySpotVars) softs.push_back(Soft{-v, -1, 0});
+    std::vector<Totalizer> totalizers;
+
+    while (lower < upper) {
+
+        for (const auto& soft : softs) _sat.assume(soft.lit);
+        Log::i("Searching for a plan of length %i (bounds: [%i,%i], %i soft literals)\n", 
+                lower, lower, upper, softs.size());
+        int result = solve(mode);
+
+        if (result == 10) {
+            // SAT: All soft literals hold, so the plan meets the lower bound
+            plan = _enc.extractPlan();
+            int newPlanLength = getPlanLength(std::get<0>(plan));
+            Log::i("Shorter plan (length %i) found\n", newPlanLength);
+            assert(newPlanLength <= lower);
+            upper = newPlanLength;
+            reportImprovedPlan(plan, upper);
+            Log::v("PLO UPDATE %i\n", upper);
+            break;
+        }
+        if (result != 20) break;
+
+        // UNSAT: Extract core from the failed soft literals
+        _stats.begin(STAGE_PLANLENGTHCOUNTING);
+        std::vector<Soft> core, remaining;
+        for (const auto& soft : softs) {
+            if (_sat.didAssumptionFail(soft.lit)) core.push_back(soft);
+            else remaining.push_back(soft);
+        }
+        if (core.empty()) {
+            // Should not happen: the formula is unsatisfiable regardless of the plan length
+            Log::w("Empty core during plan length optimization\n");
+            _stats.end(STAGE_PLANLENGTHCOUNTING);
+            break;
+        }
+        // At least one of the core's soft literals is violated
+        lower++;
+        Log::i("Core of size %i: lower bound raised to %i\n", core.size(), lower);
+
+        // Relax soft literals from former cores by one
+        softs = std::move(remaining);
+        for (const auto& soft : core) if (soft.totalizer >= 0) {
+            Totalizer& tot = totalizers[soft.totalizer];
+            for (const auto& c : tot.encode(soft.bound+1)) _sat.addClause(c);
+            int lit = tot.getAtMostLiteral(soft.bound+1);
+            if (lit != 0) softs.push_back(Soft{lit, soft.totalizer, soft.bound+1});
+        }
+        // Allow for at most one violated soft literal of the core
+        if (core.size() > 1) {
+            std::vector<int> violations;
+            for (const auto& soft : core) violations.push_back(-soft.lit);
+            totalizers.emplace_back(violations);
+            Totalizer& tot = totalizers.back();
+            for (const auto& c : tot.encode(1)) _sat.addClause(c);
+            softs.push_back(Soft{tot.getAtMostLiteral(1), (int)totalizers.size()-1, 1});
+        }
+        _stats.end(STAGE_PLANLENGTHCOUNTING);
+    }
+}
+
+void PlanOptimizer::addPrimitiveness(int layerIdx, ConstraintAddition mode, bool probing) {
+    if (mode == TRANSIENT && probing) {
+        // The main solver is not called: the probing solvers assume primitiveness themselves
+        _enc.encodePrimitiveness(layerIdx);
+        return;
+    }
+    _enc.addAssumptions(layerIdx, /*permanent=*/mode == ConstraintAddition::PERMANENT);
+    _primitiveness_assumed = true;
+}
+
+void PlanOptimizer::probeInParallel(int& lower, int& upper, std::function<std::vector<int>(int)> boundLiterals, 
+            Plan& plan, ConstraintAddition mode) {
+
+    if (lower >= upper) return;
+
+    // In permanent mode, primitiveness is part of the formula already
+    std::vector<int> primitivenessLits;
+    if (mode == TRANSIENT) primitivenessLits = _enc.getPrimitivenessLiterals(_layers.size()-1);
+
+    // The cloned solvers cannot refine the formula themselves
+    _enc.addDeferredFrameAxioms();
+    const auto& formula = _sat.getRecordedFormula();
+    Log::i("Cloning formula (%i literals) into %i solvers for parallel bound probing\n", 
+            formula.size(), _num_probing_solvers);
+    ParallelBoundProber prober(formula, VariableDomain::getMaxVar(), _num_probing_solvers, 
+            _enc.getParameters().getIntParam("s"));
+    std::vector<int> probedBounds(prober.size(), -1);
+
+    while (lower < upper) {
+
+        // Assign idle solvers to bounds spread evenly over [lower, upper-1], beginning at the top
+        size_t n = prober.size();
+        size_t solverIdx = 0;
+        for (size_t i = 0; i < n; i++) {
+            int bound = upper-1 - (int)(i * (upper-lower) / n);
+            if (bound < lower) break;
+            if (std::find(probedBounds.begin(), probedBounds.end(), bound) != probedBounds.end()) continue;
+            while (solverIdx < n && probedBounds[solverIdx] >= 0) solverIdx++;
+            if (solverIdx == n) break;
+            std::vector<int> assumptions = boundLiterals(bound);
+            assumptions.insert(assumptions.end(), primitivenessLits.begin(), primitivenessLits.end());
+            Log::v("Solver %i: searching for a plan of length <= %i (bounds: [%i,%i])\n", solverIdx, bound, lower, upper);
+            prober.probe(solverIdx, bound, std::move(assumptions));
+            probedBounds[solverIdx] = bound;
+        }
+
+        if (_sat.isTerminationRequested()) break;
+        ParallelBoundProber::Result res;
+        if (!prober.waitForResult(0.05, res)) continue;
+        probedBounds[res.solver] = -1;
+
+        if (res.result == 10) {
+            // SAT: Shorter plan found?
+            _sat.importModel(std::move(res.model));
+            Plan newPlan = _enc.extractPlan();
+            int newPlanLength = getPlanLength(std::get<0>(newPlan));
+            assert(newPlanLength <= res.bound);
+            if (newPlanLength < upper) {
+                Log::i("Shorter plan (length %i) found by solver %i\n", newPlanLength, res.solver);
+                plan = std::move(newPlan);
+                upper = newPlanLength;
+                reportImprovedPlan(plan, upper);
+                Log::v("PLO UPDATE %i\n", upper);
+            }
+        } else if (res.result == 20 && res.bound >= lower) {
+            // UNSAT: Raise lower bound
+            lower = res.bound+1;
+            Log::i("No plan of length <= %i exists\n", res.bound);
+        }
+
+        // Cancel all probes which have become pointless
+        for (size_t i = 0; i < n; i++) {
+            if (probedBounds[i] >= 0 && (probedBounds[i] >= upper || probedBounds[i] < lower)) 
+                prober.cancel(i);
+        }
+    }
+    prober.stop();
+}
+
+int PlanOptimizer::encodeLengthBound(Totalizer& tot, int minPlanLength, int bound) {
+    for (const auto& c : tot.encode(bound-minPlanLength)) _sat.addClause(c);
+    return tot.getAtMostLiteral(bound-minPlanLength);
+}
+
+int PlanOptimizer::solve(ConstraintAddition mode) {
+    // Assumptions only last for a single SAT call
+    if (mode == TRANSIENT && !_primitiveness_assumed) {
+        _enc.assumePrimitiveness(_layers.size()-1);
+    }
+    _primitiveness_assumed = false;
+    return _enc.solve();
+}
+
+void PlanOptimizer::collectOperations(Layer& l, size_t pos, FlatHashSet<int>& emptyActions, FlatHashSet<int>& actualActions) {
+    for (const auto& aSig : l.at(pos).getActions()) {
+        LOG_D("PLO %i %s?\n", pos, TOSTR(aSig));
+        int aVar = l.at(pos).getVariable(VarType::OP, aSig);
+        if (isEmptyAction(aSig)) {
+            emptyActions.insert(aVar);
+        } else {
+            actualActions.insert(aVar);
+        }
+    }
+    for (const auto& rSig : l.at(pos).getReductions()) {
+        LOG_D("PLO %i %s?\n", pos, TOSTR(rSig));
+        if (_htn.getOpTable().getReduction(rSig).getSubtasks().size() == 0) {
+            // Empty reduction
+            emptyActions.insert(l.at(pos).getVariable(VarType::OP, rSig));
+        }
+    }
+}
+
 bool PlanOptimizer::isEmptyAction(const USignature& aSig) {
     if (_htn.getBlankActionSig() == aSig)
         return true;
@@ -256,7 +561,7 @@ int PlanOptimizer::getPlanLength(const std::vector<PlanItem>& classicalPlan) {
     int currentPlanLength = 0;
     for (size_t pos = 0; pos+1 < classicalPlan.size(); pos++) {
         const auto& aSig = classicalPlan[pos].abstractTask;
-        Log::d("%s\n", TOSTR(aSig));
+        LOG_D("%s\n", TOSTR(aSig));
         // Reduction with an empty expansion?
         if (aSig._name_id < 0) continue;
         // No blank action, no second part of a split action?
@@ -8,6 +8,15 @@
 #include "sat/sat_interface.h"
 #include "sat/variable_provider.h"
 #include "sat/encoding.h"
+#include "sat/totalizer.h"
+#include "sat/parallel_bound_prober.h"
+
+// Plan length optimization engines (-oe)
+const int OPT_COUNTER_LINEAR = 0;
+const int OPT_TOTALIZER_LINEAR = 1;
+const int OPT_TOTALIZER_BINARY = 2;
+const int OPT_TOTALIZER_GEOMETRIC = 3;
+const int OPT_TOTALIZER_CORES = 4;
 
 class PlanOptimizer {
 
@@ -17,14 +26,27 @@ private:
     Encoding& _enc;
     SatInterface& _sat;
     EncodingStatistics& _stats;
+    int _engine;
+    // Number of solvers which probe plan length bounds in parallel (<= 1: none)
+    int _num_probing_solvers;
+
+    // Whether the primitiveness of the final layer is assumed for the next SAT call
+    bool _primitiveness_assumed = false;
+
+    // Called with each improved plan and its length
+    std::function<void(const Plan&, int)> _improved_plan_callback;
 
 public:
     PlanOptimizer(HtnInstance& htn, std::vector<Layer*>& layers, Encoding& enc) : 
             _htn(htn), _layers(layers), _enc(enc), 
-            _sat(_enc.getSatInterface()), _stats(_enc.getEncodingStatistics()) {}
+            _sat(_enc.getSatInterface()), _stats(_enc.getEncodingStatistics()),
+            _engine(_enc.getParameters().getIntParam("oe")),
+            _num_probing_solvers(_sat.isRecordingFormula() ? _enc.getParameters().getIntParam("pbp") : 0) {}
 
     enum ConstraintAddition { TRANSIENT, PERMANENT };
 
+    void setImprovedPlanCallback(std::function<void(const Plan&, int)> callback) {_improved_plan_callback = callback;}
+
     void optimizePlan(int upperBound, Plan& plan, ConstraintAddition mode);
 
     int findMinBySat(int lower, int upper, std::function<int(int)> varMap, 
@@ -32,6 +54,21 @@ public:
 
     bool isEmptyAction(const USignature& aSig);
     int getPlanLength(const std::vector<PlanItem>& classicalPlan);
+
+private:
+    void collectOperations(Layer& l, size_t pos, FlatHashSet<int>& emptyActions, FlatHashSet<int>& actualActions);
+    void optimizePlanWithTotalizer(int upperBound, Plan& plan, ConstraintAddition mode);
+    void searchBounds(int& lower, int& upper, Totalizer& tot, int minPlanLength, Plan& plan, ConstraintAddition mode);
+    void raiseLowerBoundByCores(int& lower, int& upper, const std::vector<int>& nonEmptySpotVars, Plan& plan, ConstraintAddition mode);
+    // Assumes or adds the primitiveness of the given layer, unless only cloned solvers are going to be called
+    void addPrimitiveness(int layerIdx, ConstraintAddition mode, bool probing);
+    void probeInParallel(int& lower, int& upper, std::function<std::vector<int>(int)> boundLiterals, 
+                Plan& plan, ConstraintAddition mode);
+    void reportImprovedPlan(const Plan& plan, int length) {
+        if (_improved_plan_callback) _improved_plan_callback(plan, length);
+    }
+    int encodeLengthBound(Totalizer& tot, int minPlanLength, int bound);
+    int solve(ConstraintAddition mode);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+
+#include <cmath>
+
+#include "product_amo.h"
+
+#include "variable_domain.h"
+#include "util/log.h"
+
+ProductAtMostOne::ProductAtMostOne(const std::vector<int>& states) : _states(states) {}
+
+std::vector<std::vector<int>> ProductAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    encode(_states, cls);
+    return cls;
+}
+
+void ProductAtMostOne::encode(const std::vector<int>& states, std::vector<std::vector<int>>& cls) {
+
+    if (states.size() <= 6) {
+        // Naive at-most-one
+        for (size_t i = 0; i < states.size(); i++) 
+            for (size_t j = i+1; j < states.size(); j++) 
+                cls.push_back({-states[i], -states[j]});
+        return;
+    }
+
+    size_t numRows = std::ceil(std::sqrt(states.size()));
+    size_t numCols = (states.size() + numRows - 1) / numRows;
+
+    std::vector<int> rowVars, colVars;
+    for (size_t i = 0; i < numRows; i++) {
+        rowVars.push_back(VariableDomain::nextVar(ROLE_IMPLIED_HELPER));
+        Log::d("VARMAP %i (__pamo_%i-%i_r%i)\n", rowVars.back(), states[0], states[states.size()-1], i);
+    }
+    for (size_t j = 0; j < numCols; j++) {
+        colVars.push_back(VariableDomain::nextVar(ROLE_IMPLIED_HELPER));
+        Log::d("VARMAP %i (__pamo_%i-%i_c%i)\n", colVars.back(), states[0], states[states.size()-1], j);
+    }
+
+    for (size_t k = 0; k < states.size(); k++) {
+        cls.push_back({-states[k], rowVars[k / numCols]});
+        cls.push_back({-states[k], colVars[k % numCols]});
+    }
+
+    encode(rowVars, cls);
+    encode(colVars, cls);
+}
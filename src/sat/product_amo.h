@@ -0,0 +1,27 @@
+
+#ifndef DOMPASCH_LILOTANE_PRODUCT_AMO_H
+#define DOMPASCH_LILOTANE_PRODUCT_AMO_H
+
+#include <vector>
+
+/*
+2-product at-most-one encoding (Chen 2010):
+The states are arranged in a grid of about sqrt(n) x sqrt(n) cells. 
+Each state implies its row and column variable, and at most one row 
+and at most one column variable may be true (recursively).
+Requires about 2*sqrt(n) helper variables and 2n + O(sqrt(n)) clauses.
+*/
+class ProductAtMostOne {
+
+private:
+    std::vector<int> _states;
+
+public:
+    ProductAtMostOne(const std::vector<int>& states);
+    std::vector<std::vector<int>> encode();
+
+private:
+    void encode(const std::vector<int>& states, std::vector<std::vector<int>>& cls);
+};
+
+#endif
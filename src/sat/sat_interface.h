@@ -8,6 +8,7 @@
 #include <iostream>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 
 #include "util/params.h"
 #include "util/log.h"
@@ -30,11 +31,32 @@ private:
     bool _began_line = false;
 
     std::vector<int> _last_assumptions;
-    std::vector<int> _no_decision_variables;
+
+    // Auxiliary variables which are defined by other variables are excluded from branching
+    const bool _mark_non_decision_vars;
+    // Variables which may occur in future clauses are frozen until they are explicitly melted
+    const bool _freeze_vars;
+    int _last_classified_var = 0;
+
+    // Copy of all added clauses (for cloning the formula into other solvers)
+    const bool _record_formula;
+    std::vector<int> _formula;
+    // Model found by another solver which replaces the solver's own model
+    std::vector<bool> _imported_model;
+
+    void* _terminate_state = nullptr;
+    int (*_terminate)(void* state) = nullptr;
 
 public:
     SatInterface(Parameters& params, EncodingStatistics& stats) : 
-                _params(params), _stats(stats), _print_formula(params.isNonzero("wf")) {
+                _params(params), _stats(stats), _print_formula(params.isNonzero("wf")),
+                _mark_non_decision_vars(params.isNonzero("ndv") && supportsDecisionVariables()),
+                _freeze_vars(params.isNonzero("fm") && supportsFreezing()),
+                _record_formula(params.getIntParam("pbp") > 1) {
+        if (params.isNonzero("ndv") && !_mark_non_decision_vars)
+            Log::w("Solver %s does not support non-decision variables - ignoring -ndv\n", ipasir_signature());
+        if (params.isNonzero("fm") && !_freeze_vars)
+            Log::w("Solver %s does not support freezing variables - ignoring -fm\n", ipasir_signature());
         _solver = ipasir_init();
         ipasir_set_seed(_solver, params.getIntParam("s"));
         if (_print_formula) _out.open("formula.cnf");
@@ -42,14 +64,14 @@ public:
     
     inline void addClause(int lit) {
         assert(lit != 0);
-        ipasir_add(_solver, lit); ipasir_add(_solver, 0);
+        addLiteral(lit); addLiteral(0);
         if (_print_formula) _out << lit << " 0\n";
         _stats._num_lits++; _stats._num_cls++;
     }
     inline void addClause(int lit1, int lit2) {
         assert(lit1 != 0);
         assert(lit2 != 0);
-        ipasir_add(_solver, lit1); ipasir_add(_solver, lit2); ipasir_add(_solver, 0);
+        addLiteral(lit1); addLiteral(lit2); addLiteral(0);
         if (_print_formula) _out << lit1 << " " << lit2 << " 0\n";
         _stats._num_lits += 2; _stats._num_cls++;
     }
@@ -57,17 +79,17 @@ public:
         assert(lit1 != 0);
         assert(lit2 != 0);
         assert(lit3 != 0);
-        ipasir_add(_solver, lit1); ipasir_add(_solver, lit2); ipasir_add(_solver, lit3); ipasir_add(_solver, 0);
+        addLiteral(lit1); addLiteral(lit2); addLiteral(lit3); addLiteral(0);
         if (_print_formula) _out << lit1 << " " << lit2 << " " << lit3 << " 0\n";
         _stats._num_lits += 3; _stats._num_cls++;
     }
     inline void addClause(const std::initializer_list<int>& lits) {
         for (int lit : lits) {
             assert(lit != 0);
-            ipasir_add(_solver, lit);
+            addLiteral(lit);
             if (_print_formula) _out << lit << " ";
         } 
-        ipasir_add(_solver, 0);
+        addLiteral(0);
         if (_print_formula) _out << "0\n";
         _stats._num_cls++;
         _stats._num_lits += lits.size();
@@ -75,10 +97,10 @@ public:
     inline void addClause(const std::vector<int>& cls) {
         for (int lit : cls) {
             assert(lit != 0);
-            ipasir_add(_solver, lit);
+            addLiteral(lit);
             if (_print_formula) _out << lit << " ";
         } 
-        ipasir_add(_solver, 0);
+        addLiteral(0);
         if (_print_formula) _out << "0\n";
         _stats._num_cls++;
         _stats._num_lits += cls.size();
@@ -86,7 +108,7 @@ public:
     inline void appendClause(int lit) {
         _began_line = true;
         assert(lit != 0);
-        ipasir_add(_solver, lit);
+        addLiteral(lit);
         if (_print_formula) _out << lit << " ";
         _stats._num_lits++;
     }
@@ -94,7 +116,7 @@ public:
         _began_line = true;
         assert(lit1 != 0);
         assert(lit2 != 0);
-        ipasir_add(_solver, lit1); ipasir_add(_solver, lit2);
+        addLiteral(lit1); addLiteral(lit2);
         if (_print_formula) _out << lit1 << " " << lit2 << " ";
         _stats._num_lits += 2;
     }
@@ -102,7 +124,7 @@ public:
         _began_line = true;
         for (int lit : lits) {
             assert(lit != 0);
-            ipasir_add(_solver, lit);
+            addLiteral(lit);
             if (_print_formula) _out << lit << " ";
             //log("%i ", lit);
         } 
@@ -111,7 +133,7 @@ public:
     }
     inline void endClause() {
         assert(_began_line);
-        ipasir_add(_solver, 0);
+        addLiteral(0);
         if (_print_formula) _out << "0\n";
         //log("0\n");
         _began_line = false;
@@ -126,10 +148,62 @@ public:
         _stats._num_asmpts++;
     }
 
+    // Assumptions only last for a single SAT call: 
+    // assumes the literals of the last call once again
+    void reassumeLastAssumptions() {
+        std::vector<int> lits = _last_assumptions;
+        for (int lit : lits) assume(lit);
+    }
+
     inline bool holds(int lit) {
+        if (!_imported_model.empty()) return lit > 0 ? _imported_model[lit] : !_imported_model[-lit];
         return ipasir_val(_solver, lit) > 0;
     }
 
+    // Decode the given model instead of the solver's own one until the next SAT call
+    void importModel(std::vector<bool>&& model) {
+        _imported_model = std::move(model);
+    }
+
+    bool isRecordingFormula() const {return _record_formula;}
+    const std::vector<int>& getRecordedFormula() const {return _formula;}
+
+    // Sets the preferred truth value of the variable in the next decisions (if supported)
+    inline void setPhase(int var, bool phase) {
+        assert(var > 0);
+        ipasir_set_phase(_solver, var, phase);
+    }
+
+    static bool supportsPhases() {
+        std::string sig = ipasir_signature();
+        std::transform(sig.begin(), sig.end(), sig.begin(), ::tolower);
+        return sig.find("cadical") != std::string::npos || sig.find("glucose") != std::string::npos;
+    }
+
+    static bool supportsDecisionVariables() {
+        std::string sig = ipasir_signature();
+        std::transform(sig.begin(), sig.end(), sig.begin(), ::tolower);
+        return sig.find("glucose") != std::string::npos;
+    }
+
+    static bool supportsFreezing() {
+        std::string sig = ipasir_signature();
+        std::transform(sig.begin(), sig.end(), sig.begin(), ::tolower);
+        return sig.find("cadical") != std::string::npos;
+    }
+
+    // Allows the solver to eliminate the variable:
+    // it is not going to occur in any further clauses or assumptions.
+    // Must be called at most once per variable.
+    void melt(int var) {
+        if (!_freeze_vars) return;
+        // Make sure that the variable has been frozen before
+        classifyNewVariables();
+        if (!isFrozenRole(VariableDomain::getRole(var))) return;
+        ipasir_set_frozen(_solver, var, false);
+        _stats._num_melted_vars++;
+    }
+
     inline bool didAssumptionFail(int lit) {
         return ipasir_failed(_solver, lit);
     }
@@ -137,9 +211,17 @@ public:
     bool hasLastAssumptions() {
         return !_last_assumptions.empty();
     }
+    const std::vector<int>& getLastAssumptions() const {return _last_assumptions;}
 
     void setTerminateCallback(void * state, int (*terminate)(void * state)) {
         ipasir_set_terminate(_solver, state, terminate);
+        _terminate_state = state;
+        _terminate = terminate;
+    }
+
+    // Polls the termination callback (outside of a SAT call)
+    bool isTerminationRequested() {
+        return _terminate != nullptr && _terminate(_terminate_state) != 0;
     }
 
     void setLearnCallback(int maxLength, void* state, void (*learn)(void * state, int * clause)) {
@@ -147,12 +229,48 @@ public:
     }
 
     int solve() {
+        if (_mark_non_decision_vars || _freeze_vars) classifyNewVariables();
+        _imported_model.clear();
         int result = ipasir_solve(_solver);
         if (_stats._num_asmpts == 0) _last_assumptions.clear();
         _stats._num_asmpts = 0;
         return result;
     }
 
+private:
+    // Excludes all new variables from branching which are fully determined
+    // by unit propagation once the decision variables are assigned,
+    // and freezes all new variables which may occur in future clauses
+    void classifyNewVariables() {
+        int maxVar = VariableDomain::getMaxVar();
+        for (int var = _last_classified_var+1; var <= maxVar; var++) {
+            VarRole role = VariableDomain::getRole(var);
+            if (_mark_non_decision_vars && (role == ROLE_QCONST_EQUALITY || role == ROLE_IMPLIED_HELPER 
+                    || role == ROLE_IMPLIED_COUNTER)) {
+                ipasir_set_decision_var(_solver, var, false);
+                _stats._num_non_decision_vars[role]++;
+            }
+            if (_freeze_vars && isFrozenRole(role)) {
+                ipasir_set_frozen(_solver, var, true);
+                _stats._num_frozen_vars++;
+            }
+        }
+        _last_classified_var = maxVar;
+    }
+
+    // Helper variables only occur in the clauses they were introduced with,
+    // whereas counter variables are extended by new clauses and assumed later on.
+    // (If an eliminated variable does occur again, the solver restores it, at a high cost.)
+    static bool isFrozenRole(VarRole role) {
+        return role != ROLE_IMPLIED_HELPER && role != ROLE_HELPER;
+    }
+
+    inline void addLiteral(int lit) {
+        ipasir_add(_solver, lit);
+        if (_record_formula) _formula.push_back(lit);
+    }
+
+public:
     ~SatInterface() {
         
         if (_params.isNonzero("wf")) {
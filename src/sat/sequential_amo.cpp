@@ -0,0 +1,34 @@
+
+#include "sequential_amo.h"
+
+#include "variable_domain.h"
+#include "util/log.h"
+
+SequentialAtMostOne::SequentialAtMostOne(const std::vector<int>& states) : _states(states) {
+
+    // Helper variable s_i: "some state among the first i+1 states holds"
+    for (size_t i = 0; i+1 < _states.size(); i++) {
+        int var = VariableDomain::nextVar(ROLE_IMPLIED_HELPER);
+        Log::d("VARMAP %i (__samo_%i-%i_%i)\n", var, states[0], states[states.size()-1], i);
+        _counter_vars.push_back(var);
+    }
+}
+
+std::vector<std::vector<int>> SequentialAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    
+    size_t n = _states.size();
+    if (n <= 1) return cls;
+
+    const auto& x = _states;
+    const auto& s = _counter_vars;
+    cls.push_back({-x[0], s[0]});
+    for (size_t i = 1; i+1 < n; i++) {
+        cls.push_back({-x[i], s[i]});
+        cls.push_back({-s[i-1], s[i]});
+        cls.push_back({-x[i], -s[i-1]});
+    }
+    cls.push_back({-x[n-1], -s[n-2]});
+
+    return cls;
+}
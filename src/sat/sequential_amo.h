@@ -0,0 +1,22 @@
+
+#ifndef DOMPASCH_LILOTANE_SEQUENTIAL_AMO_H
+#define DOMPASCH_LILOTANE_SEQUENTIAL_AMO_H
+
+#include <vector>
+
+/*
+Sequential counter at-most-one encoding (Sinz 2005): 
+n-1 helper variables, 3n-4 clauses, arc-consistent under unit propagation.
+*/
+class SequentialAtMostOne {
+
+private:
+    std::vector<int> _states;
+    std::vector<int> _counter_vars;
+
+public:
+    SequentialAtMostOne(const std::vector<int>& states);
+    std::vector<std::vector<int>> encode();
+};
+
+#endif
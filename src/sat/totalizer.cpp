@@ -0,0 +1,74 @@
+
+#include <algorithm>
+#include <assert.h>
+
+#include "totalizer.h"
+
+#include "variable_domain.h"
+#include "util/log.h"
+
+Totalizer::Totalizer(const std::vector<int>& inputs) {
+    _root = inputs.empty() ? -1 : build(inputs, 0, inputs.size());
+}
+
+int Totalizer::build(const std::vector<int>& inputs, int begin, int end) {
+    if (end-begin == 1) {
+        _nodes.push_back(Node{-1, -1, 1, std::vector<int>(1, inputs[begin])});
+        return _nodes.size()-1;
+    }
+    int mid = begin + (end-begin)/2;
+    int left = build(inputs, begin, mid);
+    int right = build(inputs, mid, end);
+    _nodes.push_back(Node{left, right, end-begin, std::vector<int>()});
+    return _nodes.size()-1;
+}
+
+std::vector<std::vector<int>> Totalizer::encode(int bound) {
+    std::vector<std::vector<int>> cls;
+    // Expressing "at most <bound>" requires the output "at least <bound>+1"
+    if (_root >= 0 && bound >= 0) extend(_root, bound+1, cls);
+    return cls;
+}
+
+int Totalizer::getAtMostLiteral(int bound) const {
+    if (_root < 0 || bound >= _nodes[_root].numInputs) return 0;
+    assert(bound >= 0);
+    assert(bound < (int)_nodes[_root].outputs.size() || Log::e("Totalizer bound %i not encoded\n", bound));
+    return -_nodes[_root].outputs[bound];
+}
+
+void Totalizer::extend(int nodeIdx, int limit, std::vector<std::vector<int>>& cls) {
+
+    if (_nodes[nodeIdx].left < 0) return;
+    limit = std::min(limit, _nodes[nodeIdx].numInputs);
+    int oldLimit = _nodes[nodeIdx].outputs.size();
+    if (limit <= oldLimit) return;
+
+    int left = _nodes[nodeIdx].left;
+    int right = _nodes[nodeIdx].right;
+    extend(left, limit, cls);
+    extend(right, limit, cls);
+
+    Node& node = _nodes[nodeIdx];
+    for (int i = oldLimit; i < limit; i++) {
+        int var = VariableDomain::nextVar(ROLE_IMPLIED_COUNTER);
+        Log::d("VARMAP %i (__tot_%i_%i)\n", var, nodeIdx, i+1);
+        node.outputs.push_back(var);
+    }
+
+    // IF a inputs below the left child AND b inputs below the right child hold
+    // THEN a+b inputs below this node hold.
+    // Sums up to the old limit have been encoded before.
+    const auto& a = _nodes[left].outputs;
+    const auto& b = _nodes[right].outputs;
+    for (int i = 0; i <= (int)a.size(); i++) {
+        for (int j = std::max(0, oldLimit+1-i); j <= (int)b.size() && i+j <= limit; j++) {
+            if (i+j == 0) continue;
+            std::vector<int> c;
+            if (i > 0) c.push_back(-a[i-1]);
+            if (j > 0) c.push_back(-b[j-1]);
+            c.push_back(node.outputs[i+j-1]);
+            cls.push_back(std::move(c));
+        }
+    }
+}
@@ -0,0 +1,46 @@
+
+#ifndef DOMPASCH_LILOTANE_TOTALIZER_H
+#define DOMPASCH_LILOTANE_TOTALIZER_H
+
+#include <vector>
+
+/*
+Incremental totalizer (Bailleux & Boufkhad 2003, Martins et al. 2014) over a set of
+input literals. Only the "upward" half of the encoding is produced, which suffices to
+express upper bounds: if the literal returned by getAtMostLiteral(k) holds, then at most
+k inputs can be true, which unit propagation detects as soon as k+1 inputs are set.
+The output nodes are only created up to the largest bound requested so far, so the
+bound can be raised (and lowered) later without re-encoding anything.
+*/
+class Totalizer {
+
+private:
+    struct Node {
+        int left;
+        int right;
+        int numInputs;
+        // _outputs[i] holds if at least i+1 inputs below this node hold
+        std::vector<int> outputs;
+    };
+    std::vector<Node> _nodes;
+    int _root;
+
+public:
+    Totalizer(const std::vector<int>& inputs);
+
+    // Returns the clauses which, in addition to all clauses returned before,
+    // are required to express any upper bound up to and including the given one.
+    std::vector<std::vector<int>> encode(int bound);
+
+    // Literal enforcing that at most <bound> inputs hold, or 0 if this is trivially true.
+    // encode(bound) must have been called before.
+    int getAtMostLiteral(int bound) const;
+
+    int getNumInputs() const {return _root < 0 ? 0 : _nodes[_root].numInputs;}
+
+private:
+    int build(const std::vector<int>& inputs, int begin, int end);
+    void extend(int nodeIdx, int limit, std::vector<std::vector<int>>& cls);
+};
+
+#endif
@@ -7,21 +7,34 @@
 int VariableDomain::_running_var_id = 1;
 bool VariableDomain::_locked = false;
 bool VariableDomain::_print_variables = false;
+bool VariableDomain::_track_roles = false;
+std::vector<char> VariableDomain::_roles;
+bool VariableDomain::_index_op_variables = false;
+OpVariableIndex VariableDomain::_op_variable_index;
 
 void VariableDomain::init(const Parameters& params) {
     _print_variables = params.isNonzero("pvn");
+    _index_op_variables = !params.isNonzero("p");
+    _track_roles = params.isNonzero("ndv") || params.isNonzero("fm");
 }
 
-int VariableDomain::nextVar() {
+int VariableDomain::nextVar(VarRole role) {
+    if (_track_roles) _roles.push_back(role);
     return _running_var_id++;
 }
 int VariableDomain::getMaxVar() {
     return _running_var_id-1;
 }
 
+const char* VariableDomain::getRoleName(VarRole role) {
+    static const char* ROLE_NAMES[NUM_VAR_ROLES] = {"op", "fact", "substitution", "qconstequality", 
+        "impliedhelper", "helper", "counter", "impliedcounter"};
+    return ROLE_NAMES[role];
+}
+
 void VariableDomain::printVar(int var, int layerIdx, int pos, const USignature& sig) {
     if (_print_variables) {
-        Log::d("VARMAP %i %s\n", var, varName(layerIdx, pos, sig).c_str());
+        LOG_D("VARMAP %i %s\n", var, varName(layerIdx, pos, sig).c_str());
     }
 }
 std::string VariableDomain::varName(int layerIdx, int pos, const USignature& sig) {
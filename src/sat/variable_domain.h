@@ -4,6 +4,21 @@
 
 #include "util/params.h"
 #include "data/signature.h"
+#include "sat/op_variable_index.h"
+
+// Role of a variable in the encoding, as classified upon its allocation
+enum VarRole {
+    ROLE_OP, ROLE_FACT, ROLE_SUBSTITUTION, ROLE_QCONST_EQUALITY,
+    // Helper variable which is only implied by other variables (e.g. a commander of an at-most-one constraint)
+    ROLE_IMPLIED_HELPER,
+    // Any other helper variable
+    ROLE_HELPER,
+    // Variable of a counter which is extended or assumed in later SAT calls (e.g. a plan length indicator)
+    ROLE_COUNTER,
+    // Counter variable which is only implied by other variables (e.g. a totalizer output)
+    ROLE_IMPLIED_COUNTER,
+    NUM_VAR_ROLES
+};
 
 class VariableDomain {
 
@@ -13,14 +28,32 @@ private:
 
     static bool _print_variables;
 
+    // Only maintained if variables are classified (see "ndv" and "fm" parameters)
+    static bool _track_roles;
+    static std::vector<char> _roles;
+
+    // Only maintained if operations cannot be decoded top-down (no predecessor clauses)
+    static bool _index_op_variables;
+    static OpVariableIndex _op_variable_index;
+
 public:
     static void init(const Parameters& params);
 
-    static int nextVar();
+    static int nextVar(VarRole role = ROLE_HELPER);
     static int getMaxVar();
 
+    static bool isTrackingRoles() {return _track_roles;}
+    static VarRole getRole(int var) {return (VarRole) _roles[var-1];}
+    static const char* getRoleName(VarRole role);
+
     static void printVar(int var, int layerIdx, int pos, const USignature& sig);
     static std::string varName(int layerIdx, int pos, const USignature& sig);
+
+    static inline void indexOpVariable(int var, int layerIdx, int pos, const USignature& sig) {
+        if (_index_op_variables) _op_variable_index.add(var, layerIdx, pos, sig);
+    }
+    static bool isOpVariableIndexed() {return _index_op_variables;}
+    static const OpVariableIndex& getOpVariableIndex() {return _op_variable_index;}
     
     static bool isLocked();
     static void lock();
@@ -65,10 +65,9 @@ public:
         int var;
         if (!_substitution_variables.count(sigSubst)) {
             assert(!VariableDomain::isLocked() || Log::e("Unknown substitution variable %s queried!\n", TOSTR(sigSubst)));
-            var = VariableDomain::nextVar();
+            var = VariableDomain::nextVar(ROLE_SUBSTITUTION);
             _substitution_variables[sigSubst] = var;
             VariableDomain::printVar(var, -1, -1, sigSubst);
-            //_no_decision_variables.push_back(var);
         } else var = _substitution_variables[sigSubst];
         return var;
     }
@@ -84,7 +83,7 @@ public:
         return _q_equality_variables.count(IntPair(qconst1, qconst2));
     }
     int encodeQConstantEqualityVar(int qconst1, int qconst2) {
-        int var = VariableDomain::nextVar();
+        int var = VariableDomain::nextVar(ROLE_QCONST_EQUALITY);
         _q_equality_variables[IntPair(qconst1, qconst2)] = var;
         return var;
     }
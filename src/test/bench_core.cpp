@@ -0,0 +1,367 @@
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/hashmap.h"
+#include "data/signature.h"
+#include "data/substitution.h"
+#include "data/position.h"
+#include "algo/arg_iterator.h"
+#include "sat/literal_tree.h"
+#include "sat/binary_amo.h"
+#include "sat/dnf2cnf.h"
+#include "sat/variable_domain.h"
+
+/*
+Microbenchmarks for core data structures and encoders.
+All inputs are generated from a fixed seed (-s) so that runs are comparable.
+Each benchmark is repeated (-reps) and the median is reported, one line per benchmark:
+<name> <median ms> <ns per op> <ops per repetition>
+Run a subset with -bench=<substring>.
+*/
+
+std::mt19937 rng;
+volatile size_t sink = 0; // prevents the optimizer from removing benchmarked work
+
+int randomInt(int min, int max) {
+    return std::uniform_int_distribution<int>(min, max)(rng);
+}
+
+// Arities of HTN operations and facts: mostly small, occasionally up to 6
+int randomArity() {
+    static std::discrete_distribution<int> dist({5, 25, 30, 20, 10, 6, 4});
+    return dist(rng);
+}
+
+USignature randomSignature(int numNames, int numConstants) {
+    std::vector<int> args(randomArity());
+    for (int& arg : args) arg = randomInt(1, numConstants);
+    return USignature(randomInt(1, numNames), std::move(args));
+}
+
+std::vector<USignature> randomSignatures(size_t n, int numNames, int numConstants) {
+    std::vector<USignature> sigs;
+    sigs.reserve(n);
+    for (size_t i = 0; i < n; i++) sigs.push_back(randomSignature(numNames, numConstants));
+    return sigs;
+}
+
+std::string _filter;
+int _reps;
+
+void bench(const char* name, const size_t& opsPerRep, std::function<void()> setup, std::function<void()> run) {
+    if (!_filter.empty() && std::string(name).find(_filter) == std::string::npos) return;
+
+    std::vector<double> times;
+    for (int rep = 0; rep <= _reps; rep++) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        // First repetition is a warm-up
+        if (rep > 0) times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size()/2];
+    Log::log_notime(Log::V0_ESSENTIAL, "%-32s %10.3f ms %10.1f ns/op %10lu ops\n",
+            name, median, 1000000 * median / std::max((size_t)1, opsPerRep), opsPerRep);
+}
+
+// Each benchmark builds its own inputs in its setup so that it can run alone:
+// fail instead of silently timing empty inputs
+void checkInput(const char* name, bool nonEmpty) {
+    if (nonEmpty) return;
+    Log::e("Benchmark %s: empty input\n", name);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    int seed = params.getIntParam("s");
+    _filter = params.getParam("bench", "");
+    _reps = std::max(1, params.getIntParam("reps", 5));
+
+    // USigSet: insert + lookup of (many duplicate) fact signatures
+    {
+        std::vector<USignature> sigs, queries;
+        USigSet set;
+        auto makeSigs = [&]() {
+            rng.seed(seed);
+            sigs = randomSignatures(200000, 300, 500);
+        };
+        bench("usigset_insert", 200000, [&]() {
+            makeSigs();
+            set = USigSet();
+            checkInput("usigset_insert", !sigs.empty());
+        }, [&]() {
+            for (const auto& sig : sigs) set.insert(sig);
+            sink += set.size();
+        });
+        bench("usigset_lookup", 200000, [&]() {
+            makeSigs();
+            set = USigSet();
+            for (const auto& sig : sigs) set.insert(sig);
+            rng.seed(seed+1);
+            queries = randomSignatures(200000, 300, 500);
+            checkInput("usigset_lookup", !set.empty() && !queries.empty());
+        }, [&]() {
+            size_t hits = 0;
+            for (const auto& sig : queries) hits += set.count(sig);
+            sink += hits;
+        });
+        bench("usignature_hash", 200000, [&]() {
+            makeSigs();
+            checkInput("usignature_hash", !sigs.empty());
+        }, [&]() {
+            USignatureHasher hasher;
+            size_t h = 0;
+            for (const auto& sig : sigs) h ^= hasher(sig);
+            sink += h;
+        });
+    }
+
+    // Substitution: construction, lookup, application, concatenation
+    {
+        std::vector<std::vector<int>> srcs, dests;
+        std::vector<USignature> sigs;
+        std::vector<Substitution> subs;
+        auto makeMappings = [&]() {
+            rng.seed(seed);
+            srcs.clear(); dests.clear();
+            for (int i = 0; i < 100000; i++) {
+                int n = randomInt(1, 4);
+                std::vector<int> src(n), dest(n);
+                for (int j = 0; j < n; j++) {
+                    src[j] = 1000 + 10*j + randomInt(0, 9);
+                    dest[j] = randomInt(1, 500);
+                }
+                srcs.push_back(std::move(src));
+                dests.push_back(std::move(dest));
+            }
+            subs.clear();
+        };
+        auto makeSubs = [&]() {
+            makeMappings();
+            for (size_t i = 0; i < srcs.size(); i++) subs.emplace_back(srcs[i], dests[i]);
+        };
+        bench("substitution_build", 100000, [&]() {
+            makeMappings();
+            checkInput("substitution_build", !srcs.empty());
+        }, [&]() {
+            for (size_t i = 0; i < srcs.size(); i++) subs.emplace_back(srcs[i], dests[i]);
+            sink += subs.size();
+        });
+        bench("substitution_apply", 100000, [&]() {
+            makeSubs();
+            rng.seed(seed+1);
+            sigs.clear();
+            for (size_t i = 0; i < subs.size(); i++) {
+                USignature sig = randomSignature(300, 500);
+                // Let some arguments be affected by the substitution
+                for (size_t j = 0; j < sig._args.size() && j < srcs[i].size(); j++)
+                    if (randomInt(0, 1)) sig._args[j] = srcs[i][j];
+                sigs.push_back(std::move(sig));
+            }
+            checkInput("substitution_apply", !subs.empty());
+        }, [&]() {
+            size_t sum = 0;
+            for (size_t i = 0; i < subs.size(); i++) sum += sigs[i].substitute(subs[i])._args.size();
+            sink += sum;
+        });
+        bench("substitution_concatenate", 100000, [&]() {
+            makeSubs();
+            checkInput("substitution_concatenate", subs.size() > 1);
+        }, [&]() {
+            size_t sum = 0;
+            for (size_t i = 0; i+1 < subs.size(); i++) sum += subs[i].concatenate(subs[i+1]).size();
+            sink += sum;
+        });
+        bench("substitution_hash", 100000, [&]() {
+            makeSubs();
+            checkInput("substitution_hash", !subs.empty());
+        }, [&]() {
+            Substitution::Hasher hasher;
+            size_t h = 0;
+            for (const auto& s : subs) h ^= hasher(s);
+            sink += h;
+        });
+    }
+
+    // LiteralTree: insert, subsumption queries, encoding
+    // Paths resemble valid tuples of substitution constraints: one value per involved q-constant
+    {
+        std::vector<std::vector<int>> paths, queries;
+        LiteralTree<int> tree;
+        auto randomPath = [&](int arity) {
+            // Values of the i-th q-constant are disjoint from those of the others,
+            // which keeps the paths sorted w.r.t. the global order of the tree
+            std::vector<int> path(arity);
+            for (size_t i = 0; i < path.size(); i++) path[i] = 1000*(i+1) + randomInt(1, 40);
+            return path;
+        };
+        auto makePaths = [&]() {
+            rng.seed(seed);
+            paths.clear();
+            for (int i = 0; i < 20000; i++) paths.push_back(randomPath(3));
+            tree = LiteralTree<int>();
+        };
+        auto makeTree = [&]() {
+            makePaths();
+            for (const auto& path : paths) tree.insert(path);
+        };
+        bench("literaltree_insert", 20000, [&]() {
+            makePaths();
+            checkInput("literaltree_insert", !paths.empty());
+        }, [&]() {
+            for (const auto& path : paths) tree.insert(path);
+            sink += tree.getSizeOfEncoding();
+        });
+        bench("literaltree_subsumes", 2000, [&]() {
+            makeTree();
+            rng.seed(seed+1);
+            queries.clear();
+            for (int i = 0; i < 2000; i++) queries.push_back(randomPath(randomInt(1, 3)));
+            checkInput("literaltree_subsumes", !tree.empty() && !queries.empty());
+        }, [&]() {
+            size_t hits = 0;
+            for (const auto& q : queries) hits += tree.subsumes(q);
+            sink += hits;
+        });
+        bench("literaltree_encode", 1, [&]() {
+            makeTree();
+            checkInput("literaltree_encode", !tree.empty());
+        }, [&]() {
+            sink += tree.encode(std::vector<int>{1, 2}).size();
+        });
+    }
+
+    // BinaryAtMostOne: group sizes as found at wide positions / large substitution domains
+    {
+        std::vector<std::vector<int>> groups;
+        size_t numStates = 0;
+        bench("binary_amo_encode", numStates, [&]() {
+            rng.seed(seed);
+            groups.clear();
+            numStates = 0;
+            for (int i = 0; i < 50; i++) {
+                std::vector<int> group(randomInt(50, 2000));
+                for (int& var : group) var = VariableDomain::nextVar();
+                numStates += group.size();
+                groups.push_back(std::move(group));
+            }
+        }, [&]() {
+            size_t numCls = 0;
+            for (const auto& group : groups) numCls += BinaryAtMostOne(group, group.size()+1).encode().size();
+            sink += numCls;
+        });
+    }
+
+    // Dnf2Cnf: disjunctive effect conditions (few terms of few literals)
+    {
+        std::vector<std::vector<int>> dnfs;
+        auto setup = [&]() {
+            rng.seed(seed);
+            dnfs.clear();
+            for (int i = 0; i < 5000; i++) {
+                std::vector<int> dnf;
+                int numTerms = randomInt(2, 6);
+                for (int t = 0; t < numTerms; t++) {
+                    int termSize = randomInt(1, 3);
+                    for (int l = 0; l < termSize; l++) dnf.push_back(randomInt(1, 1000));
+                    dnf.push_back(0);
+                }
+                dnfs.push_back(std::move(dnf));
+            }
+        };
+        bench("dnf2cnf_distributive", 5000, setup, [&]() {
+            size_t numCls = 0;
+            std::vector<int> header{-1, -2};
+            for (const auto& dnf : dnfs) Dnf2Cnf::encodeDistributive(dnf, header, [&](const std::vector<int>&) {numCls++;});
+            sink += numCls;
+        });
+        bench("dnf2cnf_encode", 5000, setup, [&]() {
+            size_t numCls = 0;
+            std::vector<int> header{-1, -2};
+            for (const auto& dnf : dnfs) Dnf2Cnf::encode(dnf, header, [&](const std::vector<int>&) {numCls++;});
+            sink += numCls;
+        });
+    }
+
+    // ArgIterator: enumeration of all instantiations over eligible constants
+    {
+        std::vector<std::vector<std::vector<int>>> eligibleArgs;
+        size_t numInstantiations = 0;
+        bench("argiterator_enumerate", numInstantiations, [&]() {
+            rng.seed(seed);
+            eligibleArgs.clear();
+            numInstantiations = 0;
+            for (int i = 0; i < 200; i++) {
+                std::vector<std::vector<int>> args(randomInt(1, 4));
+                size_t n = 1;
+                for (auto& domain : args) {
+                    domain.resize(randomInt(1, 12));
+                    for (int& c : domain) c = randomInt(1, 500);
+                    n *= domain.size();
+                }
+                numInstantiations += n;
+                eligibleArgs.push_back(std::move(args));
+            }
+        }, [&]() {
+            size_t sum = 0;
+            for (auto args : eligibleArgs) {
+                for (const auto& sig : ArgIterator(42, std::move(args))) sum += sig._args[0];
+            }
+            sink += sum;
+        });
+    }
+
+    // Position: variable encoding and lookup of ops and facts
+    {
+        std::vector<USignature> facts, queries;
+        Position pos;
+        auto makeFacts = [&]() {
+            rng.seed(seed);
+            facts = randomSignatures(100000, 300, 500);
+            pos = Position();
+            pos.setPos(1, 1);
+        };
+        bench("position_encode", 100000, [&]() {
+            makeFacts();
+            checkInput("position_encode", !facts.empty());
+        }, [&]() {
+            size_t sum = 0;
+            for (const auto& fact : facts) sum += pos.encode(VarType::FACT, fact);
+            sink += sum;
+        });
+        bench("position_lookup", 100000, [&]() {
+            makeFacts();
+            for (const auto& fact : facts) pos.encode(VarType::FACT, fact);
+            rng.seed(seed+1);
+            queries = randomSignatures(100000, 300, 500);
+            checkInput("position_lookup", !facts.empty() && queries.size() <= facts.size());
+            // Half of the queries are known facts
+            for (size_t i = 0; i < queries.size(); i += 2) queries[i] = facts[i];
+        }, [&]() {
+            size_t sum = 0;
+            for (const auto& q : queries) sum += pos.getVariableOrZero(VarType::FACT, q);
+            sink += sum;
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+
+#include <assert.h>
+#include <algorithm>
+#include <cstdlib>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "sat/variable_domain.h"
+#include "sat/at_most_one.h"
+
+bool isSatisfied(const std::vector<std::vector<int>>& cls, const std::vector<bool>& assignment) {
+    for (const auto& c : cls) {
+        bool sat = false;
+        for (int lit : c) if (assignment[std::abs(lit)] == (lit > 0)) {
+            sat = true;
+            break;
+        }
+        if (!sat) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    VariableDomain::init(params);
+    AtMostOne amo(params, "");
+
+    // Exhaustively check each encoding for small groups:
+    // a state assignment must be extensible to a model iff at most one state is true
+    for (int encoding : {AMO_PAIRWISE, AMO_BINARY, AMO_SEQUENTIAL, AMO_COMMANDER, AMO_PRODUCT}) {
+        for (int n = 1; n <= 10; n++) {
+            Log::d("%s, n=%i\n", AtMostOne::getName(encoding), n);
+
+            std::vector<int> vars;
+            for (int i = 0; i < n; i++) vars.push_back(VariableDomain::nextVar());
+            auto cls = amo.encode(encoding, vars);
+            
+            std::vector<int> helperVars;
+            for (const auto& c : cls) for (int lit : c) {
+                int var = std::abs(lit);
+                if (var > vars.back() && std::find(helperVars.begin(), helperVars.end(), var) == helperVars.end()) 
+                    helperVars.push_back(var);
+            }
+            assert(helperVars.size() < 16);
+
+            std::vector<bool> assignment(VariableDomain::getMaxVar()+1, false);
+            for (int states = 0; states < (1 << n); states++) {
+                int numTrue = 0;
+                for (int i = 0; i < n; i++) {
+                    assignment[vars[i]] = (states >> i) & 1;
+                    numTrue += assignment[vars[i]];
+                }
+                bool sat = false;
+                for (int helpers = 0; !sat && helpers < (1 << helperVars.size()); helpers++) {
+                    for (size_t i = 0; i < helperVars.size(); i++) 
+                        assignment[helperVars[i]] = (helpers >> i) & 1;
+                    sat = isSatisfied(cls, assignment);
+                }
+                assert(sat == (numTrue <= 1) || Log::e("%s, n=%i: wrong result for states %i\n", 
+                        AtMostOne::getName(encoding), n, states));
+            }
+        }
+    }
+
+    // Selection
+    assert(amo.select(2) == AMO_PAIRWISE);
+    assert(amo.select(1000) == AMO_PRODUCT);
+    assert(AtMostOne(params, "cadical-1.2.1").select(20) == AMO_SEQUENTIAL);
+    assert(AtMostOne(params, "glucose4").select(20) == AMO_COMMANDER);
+
+    return 0;
+}
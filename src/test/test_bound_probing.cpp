@@ -0,0 +1,50 @@
+
+#include <assert.h>
+#include <algorithm>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "data/htn_instance.h"
+#include "algo/planner.h"
+
+// Usage: test_bound_probing <domain> <problem> [options]
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+    // Expand and optimize indefinitely (up to the maximum depth) with two probing solvers
+    params.setParam("el", "-1");
+    params.setParam("pbp", "2");
+    if (params.getIntParam("D") == 0) params.setParam("D", "16");
+    Random::init(params.getIntParam("s"), params.getIntParam("s"));
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    if (params.getProblemFilename().empty()) {
+        Log::e("Please specify a domain file and a problem file.\n");
+        return 1;
+    }
+
+    HtnInstance htn(params);
+    Planner planner(params, htn);
+    int result = planner.findPlan();
+    assert(result == 0);
+
+    // The last call of the main solver was made at the final layer after the optimization 
+    // at a previous layer: it must not have assumed anything of that previous layer
+    Encoding& enc = planner.getEncoding();
+    std::vector<int> expected = enc.getPrimitivenessLiterals(planner.getNumLayers()-1);
+    std::vector<int> assumed = enc.getSatInterface().getLastAssumptions();
+    std::sort(expected.begin(), expected.end());
+    std::sort(assumed.begin(), assumed.end());
+    assert(assumed == expected || Log::e("%i assumptions instead of %i at the final layer\n", 
+            assumed.size(), expected.size()));
+
+    return 0;
+}
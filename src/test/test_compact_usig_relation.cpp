@@ -0,0 +1,89 @@
+
+#include <assert.h>
+#include <random>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "data/compact_usig_relation.h"
+
+typedef NodeHashMap<USignature, USigSet, USignatureHasher> USigSetMap;
+
+USignature randomSig(std::mt19937& rng) {
+    std::vector<int> args(rng() % 3);
+    for (int& arg : args) arg = 1 + rng() % 4;
+    return USignature(1 + rng() % 5, std::move(args));
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    std::mt19937 rng(params.getIntParam("s"));
+
+    for (int round = 0; round < 50; round++) {
+
+        // Expansions and predecessors as maintained by a position under construction
+        USigSetMap expansions, predecessors;
+        std::vector<USignature> parents, children;
+        for (int i = 0; i < 30; i++) {
+            USignature parent = randomSig(rng);
+            USignature child = randomSig(rng);
+            expansions[parent].insert(child);
+            predecessors[child].insert(parent);
+            parents.push_back(parent);
+            children.push_back(child);
+        }
+        CompactUSigRelation rel(expansions, predecessors);
+
+        // Apply the same removals to both representations
+        for (int i = 0; i < 5; i++) {
+            const auto& child = children[rng() % children.size()];
+            for (auto& [parent, set] : expansions) set.erase(child);
+            predecessors.erase(child);
+            rel.removeValue(child);
+
+            const auto& other = children[rng() % children.size()];
+            const auto& parent = parents[rng() % parents.size()];
+            if (predecessors.count(other)) predecessors[other].erase(parent);
+            rel.removeInverse(other, parent);
+        }
+
+        for (const auto& parent : parents) {
+            assert(rel.hasKey(parent));
+            assert(rel.getNumValues(parent) == expansions[parent].size());
+            size_t num = 0;
+            rel.forEachValue(parent, [&](const USignature& child) {
+                assert(expansions[parent].count(child));
+                num++;
+            });
+            assert(num == expansions[parent].size());
+            for (const auto& child : children) {
+                assert(rel.contains(parent, child) == (expansions[parent].count(child) > 0));
+            }
+        }
+        for (const auto& child : children) {
+            assert(rel.hasInverse(child) == (predecessors.count(child) > 0));
+            size_t expected = predecessors.count(child) ? predecessors[child].size() : 0;
+            assert(rel.getNumInverse(child) == expected);
+            rel.forEachInverse(child, [&](const USignature& parent) {
+                assert(predecessors[child].count(parent));
+                assert(rel.containsInverse(child, parent));
+            });
+        }
+
+        // Signatures which never occurred
+        USignature unknown(100, {1, 2});
+        assert(!rel.hasKey(unknown) && rel.getNumValues(unknown) == 0);
+        assert(!rel.hasInverse(unknown) && rel.getNumInverse(unknown) == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+
+#include <assert.h>
+#include <random>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "sat/variable_domain.h"
+#include "sat/dnf2cnf.h"
+
+const int NUM_VARS = 6;
+
+bool holds(const std::vector<int>& cls, const std::vector<bool>& assignment) {
+    for (int lit : cls) if (assignment[std::abs(lit)] == (lit > 0)) return true;
+    return false;
+}
+
+// (header OR dnf) under an assignment of the original variables
+bool holdsDnf(const std::vector<int>& dnf, const std::vector<int>& headerLits, const std::vector<bool>& assignment) {
+    if (holds(headerLits, assignment)) return true;
+    bool term = true;
+    bool empty = true;
+    for (int lit : dnf) {
+        if (lit == 0) {
+            if (!empty && term) return true;
+            term = true;
+            empty = true;
+        } else {
+            term &= assignment[std::abs(lit)] == (lit > 0);
+            empty = false;
+        }
+    }
+    return false;
+}
+
+// The clauses are equisatisfiable with (header OR dnf) iff, for each assignment of the original variables,
+// some assignment of the helper variables satisfies all clauses exactly if (header OR dnf) holds
+void checkEquisatisfiable(const std::vector<int>& dnf, const std::vector<int>& headerLits, 
+            const std::vector<std::vector<int>>& cls, int firstHelperVar) {
+    int numHelpers = VariableDomain::getMaxVar() - firstHelperVar + 1;
+    assert(numHelpers <= 12);
+    for (int states = 0; states < (1 << NUM_VARS); states++) {
+        std::vector<bool> assignment(VariableDomain::getMaxVar()+1, false);
+        for (int var = 1; var <= NUM_VARS; var++) assignment[var] = (states >> (var-1)) & 1;
+        bool satisfiable = false;
+        for (int helperStates = 0; helperStates < (1 << numHelpers) && !satisfiable; helperStates++) {
+            for (int i = 0; i < numHelpers; i++) assignment[firstHelperVar+i] = (helperStates >> i) & 1;
+            satisfiable = true;
+            for (const auto& c : cls) satisfiable &= holds(c, assignment);
+        }
+        assert(satisfiable == holdsDnf(dnf, headerLits, assignment) 
+                || Log::e("states=%i: clauses are not equisatisfiable with the DNF\n", states));
+    }
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    VariableDomain::init(params);
+    for (int var = 1; var <= NUM_VARS; var++) assert(VariableDomain::nextVar() == var);
+
+    // Sizes of both encodings and the choice between them
+    std::vector<int> twoPairs{1, 2, 0, 3, 4, 0};
+    assert(Dnf2Cnf::getDistributiveSize(twoPairs) == 4);
+    assert(Dnf2Cnf::getTseitinSize(twoPairs) == 5);
+    std::vector<int> threeTriples{1, 2, 3, 0, 4, 5, 6, 0, -1, -2, -3, 0};
+    assert(Dnf2Cnf::getDistributiveSize(threeTriples) == 27);
+    assert(Dnf2Cnf::getTseitinSize(threeTriples) == 10);
+    for (const auto& dnf : {twoPairs, threeTriples}) {
+        int maxVar = VariableDomain::getMaxVar();
+        Dnf2Cnf::encode(dnf, {}, [&](const std::vector<int>&) {});
+        bool tseitin = VariableDomain::getMaxVar() > maxVar;
+        assert(tseitin == (Dnf2Cnf::getDistributiveSize(dnf) > Dnf2Cnf::getTseitinSize(dnf)));
+    }
+
+    // Exhaustively check both encodings on random DNFs with and without header literals
+    std::mt19937 rng(params.getIntParam("s"));
+    auto randomInt = [&](int min, int max) {return std::uniform_int_distribution<int>(min, max)(rng);};
+    for (int i = 0; i < 200; i++) {
+        std::vector<int> dnf;
+        int numTerms = randomInt(1, 4);
+        for (int t = 0; t < numTerms; t++) {
+            int termSize = randomInt(1, 3);
+            for (int l = 0; l < termSize; l++) dnf.push_back(randomInt(1, NUM_VARS) * (randomInt(0, 1) ? 1 : -1));
+            dnf.push_back(0);
+        }
+        std::vector<int> headerLits;
+        int numHeaderLits = randomInt(0, 2);
+        for (int l = 0; l < numHeaderLits; l++) headerLits.push_back(randomInt(1, NUM_VARS) * (randomInt(0, 1) ? 1 : -1));
+
+        std::vector<std::vector<int>> cls;
+        auto emit = [&](const std::vector<int>& c) {cls.push_back(c);};
+
+        int firstHelperVar = VariableDomain::getMaxVar()+1;
+        Dnf2Cnf::encodeDistributive(dnf, headerLits, emit);
+        assert(VariableDomain::getMaxVar() == firstHelperVar-1);
+        assert(cls.size() <= Dnf2Cnf::getDistributiveSize(dnf));
+        checkEquisatisfiable(dnf, headerLits, cls, firstHelperVar);
+
+        cls.clear();
+        firstHelperVar = VariableDomain::getMaxVar()+1;
+        Dnf2Cnf::encodeTseitin(dnf, headerLits, emit);
+        assert(cls.size() == Dnf2Cnf::getTseitinSize(dnf));
+        checkEquisatisfiable(dnf, headerLits, cls, firstHelperVar);
+    }
+
+    return 0;
+}
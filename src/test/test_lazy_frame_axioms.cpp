@@ -0,0 +1,62 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "data/htn_instance.h"
+#include "algo/planner.h"
+#include "algo/plan_verifier.h"
+#include "sat/variable_domain.h"
+
+// Usage: test_lazy_frame_axioms <domain> <problem> [options]
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+    // Defer frame axioms, and keep the model of the last SAT call
+    params.setParam("lfa", "1");
+    params.setParam("of", "0");
+    Random::init(params.getIntParam("s"), params.getIntParam("s"));
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    if (params.getProblemFilename().empty()) {
+        Log::e("Please specify a domain file and a problem file.\n");
+        return 1;
+    }
+
+    HtnInstance htn(params);
+    Planner planner(params, htn);
+    int result = planner.findPlan();
+    assert(result == 0);
+
+    // The plan decoded from the refined model is valid
+    PlanVerifier verifier(htn);
+    assert(verifier.verify(planner.getPlan()) || Log::e("Plan found with deferred frame axioms was rejected\n"));
+
+    // Some frame axioms were actually deferred
+    Encoding& enc = planner.getEncoding();
+    assert(enc.getNumDeferredFrameAxioms() > 0 || Log::e("No frame axioms were deferred\n"));
+    Log::i("%i frame axioms deferred, %i refinements\n", enc.getNumDeferredFrameAxioms(), 
+            enc.getNumFrameAxiomRefinements());
+
+    // The refined model is also a model of the eager encoding,
+    // i.e., after adding all remaining deferred frame axioms
+    SatInterface& sat = enc.getSatInterface();
+    std::vector<int> model;
+    for (int var = 1; var <= VariableDomain::getMaxVar(); var++) {
+        model.push_back(sat.holds(var) ? var : -var);
+    }
+    enc.addDeferredFrameAxioms();
+    for (int lit : model) sat.assume(lit);
+    result = sat.solve();
+    assert(result == 10 || Log::e("Refined model violates the eager encoding\n"));
+
+    return 0;
+}
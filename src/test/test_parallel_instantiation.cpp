@@ -0,0 +1,69 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "data/htn_instance.h"
+#include "algo/fact_analysis.h"
+#include "algo/instantiator.h"
+#include "util/names.h"
+
+// Usage: test_parallel_instantiation <domain> <problem> [options]
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+    Random::init(params.getIntParam("s"), params.getIntParam("s"));
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    if (params.getProblemFilename().empty()) {
+        Log::e("Please specify a domain file and a problem file.\n");
+        return 1;
+    }
+
+    HtnInstance htn(params);
+    FactAnalysis analysis(htn);
+
+    // Instantiate every operation in parallel whenever possible (-ith=4) 
+    // and sequentially (-ith=1), without memoization
+    Parameters seqParams(params), parParams(params);
+    for (Parameters* p : {&seqParams, &parParams}) {
+        p->setParam("pit", "1");
+        p->setParam("ic", "0");
+    }
+    seqParams.setParam("ith", "1");
+    parParams.setParam("ith", "4");
+    Instantiator seq(seqParams, htn, analysis);
+    Instantiator par(parParams, htn, analysis);
+
+    // Both must yield the same instantiations in the same order
+    size_t numInstantiations = 0;
+    auto compare = [&](const HtnOp& op, const std::vector<USignature>& seqInst, const std::vector<USignature>& parInst) {
+        assert(seqInst == parInst || Log::e("%s: different instantiations with -ith=1 and -ith=4\n", 
+                TOSTR(op.getSignature())));
+        numInstantiations += seqInst.size();
+    };
+    for (const auto& [nameId, action] : htn.getActionTemplates()) {
+        compare(action, seq.getApplicableInstantiations(action, INSTANTIATE_FULL), 
+                par.getApplicableInstantiations(action, INSTANTIATE_FULL));
+    }
+    for (const auto& [nameId, reduction] : htn.getReductionTemplates()) {
+        compare(reduction, seq.getApplicableInstantiations(reduction, INSTANTIATE_FULL), 
+                par.getApplicableInstantiations(reduction, INSTANTIATE_FULL));
+    }
+
+    // The parallel path was actually taken
+    assert(numInstantiations > 0);
+    assert(seq.getNumParallelInstantiations() == 0);
+    assert(par.getNumParallelInstantiations() > 0);
+    Log::i("%i instantiations, %i in parallel\n", numInstantiations, par.getNumParallelInstantiations());
+
+    return 0;
+}
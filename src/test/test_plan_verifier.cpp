@@ -0,0 +1,77 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "data/htn_instance.h"
+#include "algo/planner.h"
+#include "algo/plan_verifier.h"
+
+// Usage: test_plan_verifier <domain> <problem> [options]
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+    Random::init(params.getIntParam("s"), params.getIntParam("s"));
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    if (params.getProblemFilename().empty()) {
+        Log::e("Please specify a domain file and a problem file.\n");
+        return 1;
+    }
+
+    HtnInstance htn(params);
+    Planner planner(params, htn);
+    int result = planner.findPlan();
+    assert(result == 0);
+    const Plan plan = planner.getPlan();
+
+    // The plan found by the planner is valid
+    PlanVerifier verifier(htn);
+    assert(verifier.verify(plan) || Log::e("Valid plan was rejected\n"));
+
+    int goalName = htn.nameId("<goal_action>");
+    std::vector<size_t> actionPositions;
+    for (size_t pos = 0; pos < plan.first.size(); pos++) {
+        const PlanItem& item = plan.first[pos];
+        if (item.id < 0 || item.abstractTask == htn.getBlankActionSig()) continue;
+        if (item.abstractTask._name_id == goalName) continue;
+        actionPositions.push_back(pos);
+    }
+
+    // Plan without the goal action
+    {
+        Plan tampered = plan;
+        for (auto& item : tampered.first) if (item.abstractTask._name_id == goalName) item = PlanItem();
+        assert(!verifier.verify(tampered) || Log::e("Plan without goal action was accepted\n"));
+    }
+
+    // Plan with two different actions swapped
+    for (size_t i = 0; i < actionPositions.size(); i++) {
+        for (size_t j = i+1; j < actionPositions.size(); j++) {
+            const PlanItem& first = plan.first[actionPositions[i]];
+            const PlanItem& second = plan.first[actionPositions[j]];
+            if (first.abstractTask == second.abstractTask) continue;
+            Plan tampered = plan;
+            std::swap(tampered.first[actionPositions[i]].abstractTask, tampered.first[actionPositions[j]].abstractTask);
+            assert(!verifier.verify(tampered) || Log::e("Plan with swapped actions was accepted\n"));
+            i = j = actionPositions.size();
+        }
+    }
+
+    // Plan with an unknown subtask of the root
+    {
+        Plan tampered = plan;
+        for (auto& item : tampered.second) if (item.id == 0) item.subtaskIds.push_back(1 << 30);
+        assert(!verifier.verify(tampered) || Log::e("Plan with unknown subtask was accepted\n"));
+    }
+
+    return 0;
+}
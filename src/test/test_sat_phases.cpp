@@ -0,0 +1,49 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "sat/sat_interface.h"
+#include "sat/ipasir.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    if (!SatInterface::supportsPhases()) {
+        Log::i("Solver %s does not support phases - nothing to test\n", ipasir_signature());
+        return 0;
+    }
+
+    // Each combination of phases for variables 1-4 which satisfies (1 v 2)
+    // must be exactly the model found without any conflicts
+    for (int phases = 0; phases < 16; phases++) {
+        if ((phases & 3) == 0) continue;
+        Log::d("phases=%i\n", phases);
+
+        void* solver = ipasir_init();
+        // Variables 1 and 2 are constrained, 3 and 4 only occur in tautologies
+        for (int lit : {1, 2, -5, 0, 3, -3, 0, 4, -4, 0}) ipasir_add(solver, lit);
+        for (int var = 1; var <= 4; var++) ipasir_set_phase(solver, var, phases & (1 << (var-1)));
+        // An assumption keeps solvers from trying fixed "lucky" assignments before the search
+        ipasir_assume(solver, 5);
+        assert(ipasir_solve(solver) == 10);
+
+        for (int var = 1; var <= 4; var++) {
+            bool phase = phases & (1 << (var-1));
+            assert(phase == (ipasir_val(solver, var) > 0) 
+                || Log::e("phases=%i: model does not follow the phase of variable %i\n", phases, var));
+        }
+        ipasir_release(solver);
+    }
+
+    return 0;
+}
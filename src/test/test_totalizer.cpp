@@ -0,0 +1,88 @@
+
+#include <assert.h>
+#include <cstdlib>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "sat/variable_domain.h"
+#include "sat/totalizer.h"
+
+// All totalizer clauses are definite Horn clauses once the inputs are fixed:
+// compute the least model by propagation.
+std::vector<bool> propagate(const std::vector<std::vector<int>>& cls, std::vector<bool> assignment) {
+    bool change = true;
+    while (change) {
+        change = false;
+        for (const auto& c : cls) {
+            int head = c.back();
+            assert(head > 0);
+            if (assignment[head]) continue;
+            bool fire = true;
+            for (size_t i = 0; i+1 < c.size(); i++) fire &= assignment[std::abs(c[i])];
+            if (fire) {
+                assignment[head] = true;
+                change = true;
+            }
+        }
+    }
+    return assignment;
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    VariableDomain::init(params);
+
+    // Exhaustively check each bound for small input sets while raising the encoded bound
+    // incrementally: the at-most literal of bound k must be refuted by unit propagation
+    // iff more than k inputs hold
+    for (int n = 1; n <= 9; n++) {
+        std::vector<int> vars;
+        for (int i = 0; i < n; i++) vars.push_back(VariableDomain::nextVar());
+        Totalizer tot(vars);
+        assert(tot.getNumInputs() == n);
+
+        std::vector<std::vector<int>> cls;
+        for (int encoded : {0, 2, 3, n}) {
+            auto newCls = tot.encode(encoded);
+            cls.insert(cls.end(), newCls.begin(), newCls.end());
+            Log::d("n=%i, encoded bound %i: %i clauses\n", n, encoded, cls.size());
+
+            for (int states = 0; states < (1 << n); states++) {
+                std::vector<bool> assignment(VariableDomain::getMaxVar()+1, false);
+                int numTrue = 0;
+                for (int i = 0; i < n; i++) {
+                    assignment[vars[i]] = (states >> i) & 1;
+                    numTrue += assignment[vars[i]];
+                }
+                auto model = propagate(cls, assignment);
+                for (int k = 0; k <= std::min(encoded, n); k++) {
+                    int lit = tot.getAtMostLiteral(k);
+                    if (k >= n) {
+                        assert(lit == 0);
+                        continue;
+                    }
+                    assert(lit < 0);
+                    bool refuted = model[-lit];
+                    assert(refuted == (numTrue > k) || Log::e("n=%i, k=%i: wrong result for states %i\n", n, k, states));
+                }
+            }
+        }
+    }
+
+    // Empty input
+    Totalizer empty(std::vector<int>{});
+    assert(empty.encode(3).empty());
+    assert(empty.getAtMostLiteral(0) == 0);
+
+    return 0;
+}
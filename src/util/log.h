@@ -57,6 +57,11 @@ public:
     static void init(int verbosity, bool coloredOutput);
     static void setForcePrint(bool force);
 
+    // Whether messages of the given verbosity are printed
+    static inline bool isEnabled(int verb) {
+        return verb <= verbosity;
+    }
+
     // Debug message
     static bool d(const char* str, ...);
     // Verbose info message
@@ -78,4 +83,16 @@ private:
 
 };
 
+/*
+Lazy debug and verbose messages: the arguments (e.g., TOSTR(...)) are only evaluated
+if the message is actually printed. Compiling with LILOTANE_NO_DEBUG_LOG removes
+debug messages entirely.
+*/
+#ifdef LILOTANE_NO_DEBUG_LOG
+#define LOG_D(...) ((void)(false && Log::d(__VA_ARGS__)))
+#else
+#define LOG_D(...) ((void)(Log::isEnabled(Log::V4_DEBUG) && Log::d(__VA_ARGS__)))
+#endif
+#define LOG_V(...) ((void)(Log::isEnabled(Log::V3_VERBOSE) && Log::v(__VA_ARGS__)))
+
 #endif
\ No newline at end of file
@@ -1,4 +1,7 @@
 
+#ifndef DOMPASCH_LILOTANE_MEMUSAGE_H
+#define DOMPASCH_LILOTANE_MEMUSAGE_H
+
 #include <unistd.h>
 #include <ios>
 #include <iostream>
@@ -15,7 +18,7 @@
 //
 // On failure, returns 0.0, 0.0
 
-void process_mem_usage(double& vm_usage, double& resident_set)
+inline void process_mem_usage(double& vm_usage, double& resident_set)
 {
    using std::ios_base;
    using std::ifstream;
@@ -50,4 +53,6 @@ void process_mem_usage(double& vm_usage, double& resident_set)
    long page_size_kb = sysconf(_SC_PAGE_SIZE) / 1024; // in case x86-64 is configured to use 2MB pages
    vm_usage     = vsize / 1024.0;
    resident_set = rss * page_size_kb;
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,83 @@
+
+#include <stdlib.h>
+#include <cmath>
+
+#include "util/metrics_sink.h"
+#include "util/timer.h"
+#include "util/log.h"
+
+MetricsSink::MetricsSink(const std::string& target) {
+    if (target.empty()) return;
+    if (target.rfind("fd:", 0) == 0) {
+        _out = fdopen(atoi(target.c_str()+3), "w");
+    } else {
+        _out = fopen(target.c_str(), "w");
+        _owns_stream = true;
+    }
+    if (_out == nullptr) Log::w("Could not open metrics output \"%s\"\n", target.c_str());
+}
+
+MetricsSink::~MetricsSink() {
+    if (_out == nullptr) return;
+    if (_owns_stream) fclose(_out);
+    else fflush(_out);
+}
+
+MetricsSink& MetricsSink::begin(const char* event) {
+    _record = "{";
+    add("event", event);
+    add("time", (double)Timer::elapsedSeconds());
+    return *this;
+}
+
+MetricsSink& MetricsSink::add(const char* key, long value) {
+    addKey(key);
+    _record += std::to_string(value);
+    return *this;
+}
+
+MetricsSink& MetricsSink::add(const char* key, double value) {
+    addKey(key);
+    // JSON has no representation of infinity or NaN
+    if (!std::isfinite(value)) {
+        _record += "null";
+        return *this;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6g", value);
+    _record += buf;
+    return *this;
+}
+
+MetricsSink& MetricsSink::add(const char* key, const char* value) {
+    addKey(key);
+    _record += "\"";
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '\n') _record += "\\n";
+        else if (*c == '\t') _record += "\\t";
+        else if ((unsigned char)*c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", *c);
+            _record += buf;
+        } else {
+            if (*c == '"' || *c == '\\') _record += '\\';
+            _record += *c;
+        }
+    }
+    _record += "\"";
+    return *this;
+}
+
+void MetricsSink::end() {
+    _record += "}\n";
+    if (_out == nullptr) return;
+    fputs(_record.c_str(), _out);
+    fflush(_out);
+}
+
+void MetricsSink::addKey(const char* key) {
+    if (_record.size() > 1) _record += ",";
+    _record += "\"";
+    _record += key;
+    _record += "\":";
+}
@@ -0,0 +1,37 @@
+
+#ifndef DOMPASCH_LILOTANE_METRICS_SINK_H
+#define DOMPASCH_LILOTANE_METRICS_SINK_H
+
+#include <stdio.h>
+#include <string>
+
+/*
+Writes machine-readable records as JSON lines (one JSON object per line)
+to a file or to an already open file descriptor ("fd:<n>").
+*/
+class MetricsSink {
+
+private:
+    FILE* _out = nullptr;
+    bool _owns_stream = false;
+    std::string _record;
+
+public:
+    MetricsSink(const std::string& target);
+    ~MetricsSink();
+
+    bool isActive() const {return _out != nullptr;}
+
+    MetricsSink& begin(const char* event);
+    MetricsSink& add(const char* key, long value);
+    MetricsSink& add(const char* key, unsigned long value) {return add(key, (long)value);}
+    MetricsSink& add(const char* key, int value) {return add(key, (long)value);}
+    MetricsSink& add(const char* key, double value);
+    MetricsSink& add(const char* key, const char* value);
+    void end();
+
+private:
+    void addKey(const char* key);
+};
+
+#endif
@@ -38,19 +38,34 @@ void Parameters::init(int argc, char** argv) {
 
 void Parameters::setDefaults() {
     setParam("alo", "0"); // explicitly encode "at-least-one" over elements at each position
+    setParam("amo", "0"); // at-most-one encoding
+    setParam("apf", ""); // anytime plan file
     setParam("bamot", "50"); // Binary at-most-one threshold
     setParam("cleanup", "0"); // clean up before exit?
     setParam("co", "1"); // colored output
     setParam("cs", "0"); // check solvability (without assumptions)
     setParam("d", "0"); // min depth to start SAT solving at
     setParam("D", "0"); // max depth (= num iterations)
+    setParam("do", "0"); // depth oracle: skip SAT calls at layers which cannot contain a plan
     setParam("edo", "1"); // eliminate dominated operations
     setParam("el", "0"); // extra layers after initial solution (-1: expand indefinitely)
+    setParam("fm", "0"); // freeze variables of unfinished positions, melt the others
+    setParam("ic", "1"); // instantiation cache
     setParam("ip", "0"); // implicit primitiveness
+    setParam("ith", "0"); // instantiation threads (0: number of hardware threads)
+    setParam("lfa", "0"); // lazy frame axioms
+    setParam("mb", "0"); // memory budget in MB (0: none)
+    setParam("mbd", ""); // memory budget spill directory (default: $TMPDIR or /tmp)
+    setParam("mf", ""); // metrics file
     setParam("mp", "2"); // mine preconditions
+    setParam("ndv", "0"); // mark auxiliary variables as non-decision variables
     setParam("nps", "0"); // non-primitive fact supports
+    setParam("nv", "1"); // natively verify plan before printing it
+    setParam("oe", "0"); // plan length optimization engine
     setParam("of", "0"); // optimization factor
     setParam("p", "1"); // encode predecessor operations
+    setParam("pbp", "0"); // parallel bound probing: number of solvers (<= 1: none)
+    setParam("pit", "10000"); // parallel instantiation threshold
     setParam("pvn", "0"); // print variable names
     setParam("qcm", "0"); // q-constant mutexes: size threshold
     setParam("plc", "0"); // print learnt clauses
@@ -61,6 +76,10 @@ void Parameters::setDefaults() {
     setParam("s", "0"); // random seed
     setParam("sace", "0"); // split actions with (potentially) conflicting effects
     setParam("sqq", "1"); // share q-constants
+    setParam("sf", ""); // status file
+    setParam("sfi", "5"); // status file update interval
+    setParam("sle", "0"); // selective layer expansion
+    setParam("spf", ""); // stage profile file
     setParam("srfa", "1"); // skip redundant frame axioms
     setParam("stats", "0"); // output domain statistics and exit
     setParam("stl", "0"); // SAT time limit
@@ -68,6 +87,8 @@ void Parameters::setDefaults() {
     setParam("svp", "0"); // set variable phases
     setParam("T", "0"); // max. time (secs) for finding an initial plan
     setParam("tc", "1"); // tree conversion for DNF2CNF
+    setParam("tf", ""); // trace file
+    setParam("tfs", "1048576"); // trace buffer size (events)
     setParam("v", "2"); // verbosity
     setParam("aar", "1"); // acknowledge action repetitions
     setParam("vp", "0"); // verify plan before printing it
@@ -86,21 +107,47 @@ void Parameters::printUsage() {
     Log::i("\n");
     Log::i(" -aar=<0|1>          Acknowledge action repetitions and encode them in a reduced form\n");
     Log::i(" -alo=<0|1>          Explicitly encode at-least-one constraints over operations at each position\n");
-    Log::i(" -bamot=<int>        Binary at-most-one threshold\n");
+    Log::i(" -amo=<0..4>         At-most-one encoding: 0=auto (by group size and solver), 1=pairwise below -bamot else binary,\n");
+    Log::i("                     2=sequential counter, 3=commander, 4=2-product\n");
+    Log::i(" -apf=<file>         Anytime plan output: write each improved plan as a JSON line with its length, layer and time\n");
+    Log::i("                     to <file> (or to an open file descriptor with fd:<n>) as soon as it is found\n");
+    Log::i(" -bamot=<int>        Binary at-most-one threshold (with -amo=0: threshold for 2-product encoding)\n");
     Log::i(" -cleanup=<0|1>      0 to immediately exit through syscall after solution has been printed; 1 to exit normally\n");
     Log::i(" -co=<0|1>           Colored terminal output\n");
     Log::i(" -cs=<0|1>           Check solvability: When some layer is UNSAT, re-run SAT solver without assumptions\n");
     Log::i("                     to see whether the formula has become generally unsatisfiable\n");
     Log::i(" -d=<depth>          Minimum depth to begin SAT solving at\n");
     Log::i(" -D=<depth>          Maximum depth to explore (0 : no limit)\n");
+    Log::i(" -do=<0|1>           Depth oracle: skip SAT calls at layers which provably cannot contain a plan\n");
+    Log::i("                     (relaxed reachability of each position, minimum number of actions of any plan)\n");
     Log::i(" -el=<int>           Number of extra layers to encode after an initial solution was found (use with -of=...)\n");
+    Log::i(" -fm=<0|1>           Freeze variables which may occur in future clauses and melt the operation variables of finished\n");
+    Log::i("                     positions, allowing the solver to eliminate them; only has an effect with CaDiCaL\n");
+    Log::i(" -ic=<0|1>           Memoize instantiations of operations as long as the reachable facts do not change\n");
     Log::i(" -ip=<0|1>           Implicit primitiveness instead of defining each op as primitive XOR nonprimitive\n");
+    Log::i(" -ith=<threads>      Number of threads for parallel instantiation (0: number of hardware threads)\n");
+    Log::i(" -lfa=<0|1>          Lazy frame axioms: withhold frame axioms of facts which are no precondition at their position\n");
+    Log::i("                     and add them only when a model violates them, then solve again; each model is checked\n");
+    Log::i("                     against all withheld frame axioms of all layers, which costs time linear in their number\n");
+    Log::i(" -mb=<MB>            Memory budget: when the RSS reaches 90%% of <MB>, drop caches and then spill\n");
+    Log::i("                     operation variables of finished layers to a temporary file, trading speed for memory (0: no budget)\n");
+    Log::i(" -mbd=<dir>          Directory for the spill file of -mb (default: $TMPDIR or /tmp)\n");
+    Log::i(" -mf=<file|fd:n>     Write one JSON record per layer, per SAT call and for the final plan to <file> or to file descriptor <n>\n");
     Log::i(" -mp=<0|1|2>         Mine preconditions for reductions from their (recursive) subtasks:\n");
     Log::i("                     0=none, 1=use mined prec. for instantiation only, 2=use mined prec. everywhere\n");
+    Log::i(" -ndv=<0|1>          Exclude auxiliary variables which are determined by other variables from branching;\n");
+    Log::i("                     only has an effect with solvers which support it (e.g. Glucose)\n");
     Log::i(" -nps=<0|1>          Nonprimitive support: Enable encoding explicit fact supports for reductions\n");
+    Log::i(" -nv=<0|1>           Verify plan natively (executability, decomposition, goal) before printing it\n");
+    Log::i(" -oe=<0..4>          Plan length optimization engine: 0=unary counter, decreasing the bound by one;\n");
+    Log::i("                     totalizer with 1=linear, 2=binary, 3=geometric search of the bound, 4=core-guided lower bounds\n");
     Log::i(" -of=<factor>        Plan length optimization factor: spend up to <factor> * <original solving time> for optimization\n");
     Log::i("                     (-1 for exhaustive optimization)\n");
     Log::i(" -p=<0|1>            Encode predecessor operations\n");
+    Log::i(" -pbp=<solvers>      Probe plan length bounds with <solvers> cloned SAT solvers in parallel during optimization\n");
+    Log::i("                     (records the entire formula; not with -oe=4)\n");
+    Log::i(" -pit=<count>        Instantiate an operation in parallel if it has at least <count> candidate instantiations\n");
+    Log::i("                     (0: never)\n");
     Log::i(" -psr=<0|1>          Primitivize simple reductions\n");
     Log::i(" -pvn=<0|1>          Print variable names\n");
     Log::i(" -qcm=<limit>        Collect up to <limit> q-constant mutexes per tuple of q-constants\n");
@@ -111,11 +158,23 @@ void Parameters::printUsage() {
     Log::i(" -qq=<0|1>           For each action and reduction, introduces q-constants for ALL ambiguous free parameters (replaces -q)\n");
     Log::i(" -s=<int>            Random seed\n");
     Log::i(" -sqq=<0|1>          Share q-constants among operations of a position if they have the same effective domain\n");
+    Log::i(" -sf=<file>          Periodically rewrite a status file (phase, layer, position, SAT time, best plan length, RSS);\n");
+    Log::i("                     a status report can also be requested at any time by sending SIGUSR1\n");
+    Log::i(" -sfi=<secs>         Interval between status file updates\n");
+    Log::i(" -sle=<0|1>          Selective layer expansion: after an unsuccessful SAT call, only expand positions whose\n");
+    Log::i("                     primitiveness is among the failed assumptions and repeat the others' reductions as is\n");
+    Log::i(" -spf=<file>         Write time, clauses, literals, variables and memory per stage and position to <file> (CSV)\n");
     Log::i(" -srfa=<0|1>         Skip redundant frame axioms\n");
     Log::i(" -stats=<0|1>        Output domain statistics and exit\n");
     Log::i(" -stl=<limit>        SAT time limit: Set limit in seconds for a SAT solver call. Limit is discarded after first such interrupt.\n");
+    Log::i(" -svp=<0|1>          Set phases of new variables from a model of the previous layer without assumptions;\n");
+    Log::i("                     the extra SAT call (unless -cs=1) takes at most as long as the call with assumptions;\n");
+    Log::i("                     only has an effect with solvers which support phases (e.g. CaDiCaL, Glucose)\n");
     Log::i(" -T=<0|secs>         Try finding an initial plan for up to #secs (without optimization: total allowed runtime; 0: no limit)\n");
     Log::i(" -tc=<0|1>           Use tree conversion for DNF 2 CNF transformation instead of distributive law\n");
+    Log::i(" -tf=<file>          Write a timeline of instantiation, encoding and solving to <file> (Chrome trace format);\n");
+    Log::i("                     requires a build with -DLILOTANE_TRACE=1\n");
+    Log::i(" -tfs=<events>       Capacity of the trace buffer: only the most recent <events> events are retained\n");
     Log::i(" -v=<verb>           Verbosity: 0=essential 1=warnings 2=information 3=verbose 4=debug\n");
     Log::i(" -vp=<0|1>           Verify plan (using pandaPIparser) before printing it\n");
     Log::i(" -wf=<0|1>           Write generated formula to text file \"f.cnf\" (with assumptions used in final call)\n");
@@ -2,4 +2,5 @@
 #include "signal_manager.h"
 
 bool SignalManager::exiting = false;
-int SignalManager::numSignals = 0;
\ No newline at end of file
+int SignalManager::numSignals = 0;
+volatile std::sig_atomic_t SignalManager::statusRequested = 0;
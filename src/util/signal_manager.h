@@ -3,12 +3,15 @@
 #define DOMPASCH_LILOTANE_SIGNAL_MANAGER_H
 
 #include <stdlib.h>
+#include <csignal>
 
 class SignalManager {
 
 private:
     static bool exiting;
     static int numSignals;
+    // Set from a signal handler
+    static volatile std::sig_atomic_t statusRequested;
 
 public:
     static inline void signalExit() {
@@ -22,6 +25,15 @@ public:
     static inline bool isExitSet() {
         return exiting;
     }
+    static inline void signalStatusRequest() {
+        statusRequested = 1;
+    }
+    // Returns whether a status report was requested since the last call
+    static inline bool consumeStatusRequest() {
+        if (!statusRequested) return false;
+        statusRequested = 0;
+        return true;
+    }
 };
 
 #endif
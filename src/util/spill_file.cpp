@@ -0,0 +1,60 @@
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include "util/spill_file.h"
+#include "util/log.h"
+
+SpillFile::~SpillFile() {
+    if (_map != nullptr) munmap(_map, _mapped_size);
+    if (_fd >= 0) close(_fd);
+}
+
+bool SpillFile::open(const std::string& directory) {
+    std::string path = (directory.empty() ? "." : directory) + "/lilotane-spill-XXXXXX";
+    std::vector<char> pathBuf(path.begin(), path.end());
+    pathBuf.push_back('\0');
+    _fd = mkstemp(pathBuf.data());
+    if (_fd < 0) {
+        Log::w("Could not create spill file in \"%s\": %s\n", directory.c_str(), strerror(errno));
+        return false;
+    }
+    // The file remains accessible through the descriptor only
+    unlink(pathBuf.data());
+    return true;
+}
+
+long SpillFile::append(const std::vector<int>& words) {
+    if (_fd < 0) return -1;
+    const char* buf = (const char*) words.data();
+    size_t numBytes = words.size() * sizeof(int);
+    size_t done = 0;
+    // Retry partial writes; the file only grows once all words have been written
+    while (done < numBytes) {
+        ssize_t written = pwrite(_fd, buf+done, numBytes-done, _size+done);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            Log::w("Could not write to spill file: %s\n", written < 0 ? strerror(errno) : "no space left");
+            return -1;
+        }
+        done += written;
+    }
+    size_t offset = _size;
+    _size += numBytes;
+    return offset;
+}
+
+const char* SpillFile::data() {
+    if (_size == _mapped_size) return _map;
+    if (_map != nullptr) munmap(_map, _mapped_size);
+    _map = (char*) mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (_map == MAP_FAILED) {
+        Log::e("Could not map spill file: %s\n", strerror(errno));
+        abort();
+    }
+    _mapped_size = _size;
+    return _map;
+}
@@ -0,0 +1,39 @@
+
+#ifndef DOMPASCH_LILOTANE_SPILL_FILE_H
+#define DOMPASCH_LILOTANE_SPILL_FILE_H
+
+#include <string>
+#include <vector>
+
+/*
+Append-only temporary file whose contents are read back through a read-only memory mapping.
+Data is addressed by the offset returned from append(); the file is unlinked right after
+creation, so it disappears together with the process. Appending invalidates pointers
+obtained from data() before, so readers need to keep offsets, not pointers.
+*/
+class SpillFile {
+
+private:
+    int _fd = -1;
+    size_t _size = 0;
+    char* _map = nullptr;
+    size_t _mapped_size = 0;
+
+public:
+    SpillFile() = default;
+    ~SpillFile();
+
+    // Creates the (anonymous) spill file in the given directory; returns false on failure
+    bool open(const std::string& directory);
+    bool isOpen() const {return _fd >= 0;}
+
+    // Appends the given words to the file and returns the byte offset they were written at
+    // (or -1 if writing failed, leaving the size of the file's valid contents unchanged)
+    long append(const std::vector<int>& words);
+
+    // Pointer to the mapped file contents; (re-)maps the file if it has grown since
+    const char* data();
+    size_t size() const {return _size;}
+};
+
+#endif
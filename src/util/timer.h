@@ -1,4 +1,7 @@
 
+#ifndef DOMPASCH_LILOTANE_TIMER_H
+#define DOMPASCH_LILOTANE_TIMER_H
+
 #include <chrono>
 
 using namespace std::chrono;
@@ -24,4 +27,6 @@ public:
     static float elapsedSeconds() {
         return now() - startTime;
     }
-};
\ No newline at end of file
+};
+
+#endif
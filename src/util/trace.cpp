@@ -0,0 +1,57 @@
+
+#include <chrono>
+#include <stdio.h>
+
+#include "util/trace.h"
+#include "util/log.h"
+
+std::vector<Trace::Event> Trace::_events;
+std::atomic<uint64_t> Trace::_num_events(0);
+bool Trace::_enabled = false;
+
+static std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+static std::atomic<uint32_t> numThreads(0);
+
+void Trace::init(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size *= 2;
+    _events.resize(size);
+    _num_events = 0;
+    traceStart = std::chrono::steady_clock::now();
+    _enabled = true;
+}
+
+int64_t Trace::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - traceStart).count();
+}
+
+uint32_t Trace::getThreadId() {
+    thread_local uint32_t id = numThreads++;
+    return id;
+}
+
+void Trace::dump(const std::string& filename) {
+    if (!_enabled) return;
+
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == nullptr) {
+        Log::w("Could not open trace file \"%s\"\n", filename.c_str());
+        return;
+    }
+
+    uint64_t end = _num_events.load();
+    uint64_t begin = end - getNumRetainedEvents();
+    if (begin > 0) Log::w("Trace buffer overflow: %lu oldest events were dropped\n", begin);
+
+    fputs("{\"traceEvents\":[\n", f);
+    for (uint64_t i = begin; i < end; i++) {
+        const Event& event = _events[i & (_events.size()-1)];
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%ld,\"pid\":1,\"tid\":%u%s}\n", 
+                i == begin ? "" : ",", event.name, event.phase, (long)event.timeMicros, event.threadId, 
+                event.phase == 'i' ? ",\"s\":\"t\"" : "");
+    }
+    fputs("],\"displayTimeUnit\":\"ms\"}\n", f);
+    fclose(f);
+    Log::i("Wrote %lu trace events to %s\n", end-begin, filename.c_str());
+}
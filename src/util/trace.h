@@ -0,0 +1,87 @@
+
+#ifndef DOMPASCH_LILOTANE_TRACE_H
+#define DOMPASCH_LILOTANE_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+Records begin/end events of scoped regions into a fixed-size ring buffer which can be
+dumped in Chrome trace format (chrome://tracing, Perfetto). Events are claimed by an
+atomic counter, so several threads can record concurrently without locking; when the
+buffer is full, the oldest events are overwritten.
+
+The TRACE_* macros only exist if compiled with LILOTANE_TRACE; otherwise they vanish.
+If compiled in but not enabled at runtime, each macro costs a single branch.
+Event names must be string literals (or otherwise outlive the tracer).
+*/
+class Trace {
+
+private:
+    struct Event {
+        const char* name;
+        int64_t timeMicros;
+        uint32_t threadId;
+        char phase;
+    };
+
+    static std::vector<Event> _events;
+    static std::atomic<uint64_t> _num_events;
+    static bool _enabled;
+
+public:
+    // Enables tracing with a ring buffer of the given capacity (rounded up to a power of two)
+    static void init(size_t capacity);
+    static inline bool isEnabled() {return _enabled;}
+
+    static inline void record(const char* name, char phase) {
+        uint64_t idx = _num_events.fetch_add(1, std::memory_order_relaxed);
+        Event& event = _events[idx & (_events.size()-1)];
+        event.name = name;
+        event.timeMicros = nowMicros();
+        event.threadId = getThreadId();
+        event.phase = phase;
+    }
+
+    // Writes all retained events as a Chrome trace (JSON) to the given file.
+    // Must not be called while other threads are still recording.
+    static void dump(const std::string& filename);
+
+    static uint64_t getNumEvents() {return _num_events.load();}
+    static size_t getNumRetainedEvents() {return std::min((uint64_t)_events.size(), _num_events.load());}
+
+private:
+    static int64_t nowMicros();
+    static uint32_t getThreadId();
+};
+
+class TraceScope {
+
+private:
+    const char* _name;
+
+public:
+    TraceScope(const char* name) : _name(Trace::isEnabled() ? name : nullptr) {
+        if (_name != nullptr) Trace::record(_name, 'B');
+    }
+    ~TraceScope() {
+        if (_name != nullptr) Trace::record(_name, 'E');
+    }
+};
+
+#ifdef LILOTANE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// Records a begin event now and the matching end event at the end of the enclosing scope
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(__trace_scope_, __LINE__)(name)
+// Records a single point in time
+#define TRACE_INSTANT(name) do { if (Trace::isEnabled()) Trace::record(name, 'i'); } while (0)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#endif
+
+#endif